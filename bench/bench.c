@@ -0,0 +1,393 @@
+/*
+ * Instruction count benchmarks of the hot functions
+ *
+ * Runs bare metal on the QEMU microbit machine (Cortex-M0). The semihosting
+ * command line selects a benchmark and the number of calls, tools/bench runs
+ * it with and without calls under the QEMU instruction counting plugin and
+ * divides the difference. The empty benchmark measures the loop itself.
+ *
+ * The application file is included to reach its static functions. The LCD
+ * driver is replaced by stubs and the integer division uses libgcc instead
+ * of the LPC11U24 ROM divider, which QEMU doesn't have.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdlib.h>
+#include "main.c"
+#include "ring_buffer.h"
+
+// interrupt handler in hardware.c
+void SysTick_Handler(void);
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+// semihosting operations
+#define SYS_WRITE0          0x04
+#define SYS_GET_CMDLINE     0x15
+#define SYS_EXIT            0x18
+
+// exit reasons
+#define ADP_STOPPED_APPLICATION_EXIT    0x20026
+#define ADP_STOPPED_RUN_TIME_ERROR      0x20023
+
+#define RING_BUFFER_SIZE    32
+#define COUNT(x)            (sizeof(x) / sizeof(x[0]))
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct bench_t {
+    const char *name;
+    void (*setup)(void);
+    void (*run)(uint32_t i);
+} bench_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+// inputs are read from volatiles so the compiler can't fold the calls
+static volatile float g_float_input = -12.345f;
+static volatile int32_t g_int_input = 12345;
+static volatile tempo_t g_tempo_input;
+static const char * volatile g_unit_input = "BPM";
+static volatile uint32_t g_sink;
+
+static cc_assignment_t g_assignment;
+static option_t g_option, *g_option_list[] = {&g_option};
+static uint32_t g_tap_time;
+
+static RINGBUFF_T g_ring_buffer;
+static uint8_t g_ring_data[RING_BUFFER_SIZE];
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void str16_set(str16_t *str, const char *text)
+{
+    for (str->size = 0; text[str->size]; str->size++)
+        str->text[str->size] = text[str->size];
+
+    str->text[str->size] = 0;
+}
+
+static void empty_run(uint32_t i)
+{
+    (void) i;
+}
+
+static void systick_run(uint32_t i)
+{
+    (void) i;
+    SysTick_Handler();
+}
+
+static void hw_led_set_run(uint32_t i)
+{
+    hw_led_set(i & 0x03, LED_W, (i & 0x04) ? LED_ON : LED_OFF, 0, 0);
+}
+
+static void toggle_setup(void)
+{
+    g_assignment.actuator_id = 1;
+    g_assignment.mode = CC_MODE_TOGGLE;
+    str16_set(&g_assignment.label, "Gain");
+}
+
+static void options_setup(void)
+{
+    toggle_setup();
+    g_assignment.mode = CC_MODE_OPTIONS;
+    g_assignment.list_count = 1;
+    g_assignment.list_items = g_option_list;
+    str16_set(&g_option.label, "Tube");
+}
+
+static void tap_tempo_setup(void)
+{
+    toggle_setup();
+    g_assignment.mode = CC_MODE_TAP_TEMPO;
+    g_assignment.value = 120.0f;
+    g_assignment.min = 20.0f;
+    g_assignment.max = 280.0f;
+    str16_set(&g_assignment.label, "Delay");
+    str16_set(&g_assignment.unit, "BPM");
+}
+
+static void update_lcds_run(uint32_t i)
+{
+    (void) i;
+    update_lcds(&g_assignment);
+}
+
+#ifndef INTEGER_ONLY
+static void float_to_str_run(uint32_t i)
+{
+    char buffer[16];
+    (void) i;
+    g_sink = float_to_str(g_float_input, buffer, sizeof(buffer), 2);
+}
+#else
+static void milli_to_str_run(uint32_t i)
+{
+    char buffer[16];
+    (void) i;
+    g_sink = milli_to_str(g_int_input, buffer, sizeof(buffer), 2);
+}
+#endif
+
+static void int_to_str_run(uint32_t i)
+{
+    char buffer[16];
+    (void) i;
+    g_sink = int_to_str(g_int_input, buffer, sizeof(buffer), 0, 0);
+}
+
+static void convert_to_ms_setup(void)
+{
+    g_tempo_input = TEMPO(120.0f);
+}
+
+static void convert_to_ms_run(uint32_t i)
+{
+    (void) i;
+    g_sink = convert_to_ms(g_unit_input, g_tempo_input);
+}
+
+static void handle_tap_tempo_setup(void)
+{
+    tap_tempo_setup();
+    g_assignment.actuator_id = 0;
+    g_assignment.value = 500.0f;
+    g_assignment.min = 100.0f;
+    g_assignment.max = 2000.0f;
+    str16_set(&g_assignment.unit, "ms");
+
+    g_current_assignment[0] = &g_assignment;
+    g_tap_tempo[0].state = TT_COUNTING;
+    g_tap_tempo[0].max = 2000;
+
+    coalescer_init(g_foot_value, ACTUATORS_COUNT);
+}
+
+static void handle_tap_tempo_run(uint32_t i)
+{
+    // human taps around 120 bpm
+    g_tap_time += 490000 + ((i & 0x07) * 3000);
+    handle_tap_tempo(0, g_tap_time);
+}
+
+static void ring_buffer_setup(void)
+{
+    RingBuffer_Init(&g_ring_buffer, g_ring_data, 1, RING_BUFFER_SIZE);
+}
+
+static void ring_buffer_run(uint32_t i)
+{
+    uint8_t data = i;
+    RingBuffer_Insert(&g_ring_buffer, &data);
+    RingBuffer_Pop(&g_ring_buffer, &data);
+    g_sink = data;
+}
+
+static void ring_buffer_mult_run(uint32_t i)
+{
+    uint8_t data[16] = {i};
+    RingBuffer_InsertMult(&g_ring_buffer, data, sizeof(data));
+    g_sink = RingBuffer_PopMult(&g_ring_buffer, data, sizeof(data));
+}
+
+static const bench_t g_benchs[] = {
+    {"empty", 0, empty_run},
+    {"SysTick_Handler", 0, systick_run},
+    {"hw_led_set", 0, hw_led_set_run},
+    {"update_lcds_toggle", toggle_setup, update_lcds_run},
+    {"update_lcds_options", options_setup, update_lcds_run},
+    {"update_lcds_tap_tempo", tap_tempo_setup, update_lcds_run},
+#ifndef INTEGER_ONLY
+    {"float_to_str", 0, float_to_str_run},
+#else
+    {"milli_to_str", 0, milli_to_str_run},
+#endif
+    {"int_to_str", 0, int_to_str_run},
+    {"convert_to_ms", convert_to_ms_setup, convert_to_ms_run},
+    {"handle_tap_tempo", handle_tap_tempo_setup, handle_tap_tempo_run},
+    {"RingBuffer_Insert_Pop", ring_buffer_setup, ring_buffer_run},
+    {"RingBuffer_InsertMult_PopMult_16", ring_buffer_setup, ring_buffer_mult_run},
+};
+
+
+static int semihosting(int operation, void *arg)
+{
+    register int r0 __asm__ ("r0") = operation;
+    register void *r1 __asm__ ("r1") = arg;
+
+    __asm__ volatile ("bkpt 0xAB" : "+r" (r0) : "r" (r1) : "memory");
+
+    return r0;
+}
+
+static void bench_exit(int reason)
+{
+    semihosting(SYS_EXIT, (void *) (intptr_t) reason);
+    while (1);
+}
+
+static void bench_print(const char *text)
+{
+    semihosting(SYS_WRITE0, (void *) text);
+}
+
+// next word of the command line, null terminated in place
+static char *next_word(char **cursor)
+{
+    char *word = *cursor;
+
+    while (*word == ' ')
+        word++;
+
+    char *end = word;
+    while (*end && *end != ' ')
+        end++;
+
+    *cursor = (*end ? end + 1 : end);
+    *end = 0;
+
+    return (*word ? word : 0);
+}
+
+static void bench_main(void)
+{
+    static char cmdline[128];
+    struct {
+        char *buffer;
+        int size;
+    } block = {cmdline, sizeof(cmdline)};
+
+    if (semihosting(SYS_GET_CMDLINE, &block) != 0)
+        bench_exit(ADP_STOPPED_RUN_TIME_ERROR);
+
+    // program name, benchmark and number of calls
+    char *cursor = cmdline;
+    next_word(&cursor);
+    char *name = next_word(&cursor);
+    char *calls = next_word(&cursor);
+
+    if (name && strcmp(name, "list") == 0)
+    {
+        for (unsigned int i = 0; i < COUNT(g_benchs); i++)
+        {
+            bench_print("bench: ");
+            bench_print(g_benchs[i].name);
+            bench_print("\n");
+        }
+
+        bench_exit(ADP_STOPPED_APPLICATION_EXIT);
+    }
+
+    for (unsigned int i = 0; name && calls && i < COUNT(g_benchs); i++)
+    {
+        const bench_t *bench = &g_benchs[i];
+        if (strcmp(name, bench->name))
+            continue;
+
+        if (bench->setup)
+            bench->setup();
+
+        uint32_t count = atoi(calls);
+        for (uint32_t j = 0; j < count; j++)
+            bench->run(j);
+
+        bench_exit(ADP_STOPPED_APPLICATION_EXIT);
+    }
+
+    bench_print("bench: unknown benchmark\n");
+    bench_exit(ADP_STOPPED_RUN_TIME_ERROR);
+}
+
+static void bench_fault(void)
+{
+    bench_print("bench: fault\n");
+    bench_exit(ADP_STOPPED_RUN_TIME_ERROR);
+}
+
+static void bench_reset(void)
+{
+    extern uint32_t _etext, _data, _edata, _bss, _ebss;
+
+    uint32_t *src = &_etext, *dst = &_data;
+    while (dst < &_edata)
+        *dst++ = *src++;
+
+    for (dst = &_bss; dst < &_ebss; )
+        *dst++ = 0;
+
+    bench_main();
+}
+
+extern uint32_t _vStackTop;
+
+__attribute__ ((used, section(".isr_vector")))
+static void (* const g_vectors[])(void) = {
+    (void (*)(void)) &_vStackTop,
+    bench_reset,
+    bench_fault,    // NMI
+    bench_fault,    // hard fault
+};
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// the LCD driver is replaced by stubs
+
+__attribute__ ((noinline)) int clcd_init(uint8_t config, const clcd_gpio_t *gpio)
+{
+    (void) config;
+    (void) gpio;
+    return 0;
+}
+
+__attribute__ ((noinline)) void clcd_control(int lcd_id, int on_off)
+{
+    g_sink = lcd_id + on_off;
+}
+
+__attribute__ ((noinline)) void clcd_clear(int lcd_id)
+{
+    g_sink = lcd_id;
+}
+
+__attribute__ ((noinline)) void clcd_print(int lcd_id, const char *str)
+{
+    g_sink = lcd_id + str[0];
+}
+
+__attribute__ ((noinline)) void clcd_cursor_set(int lcd_id, int line, int col)
+{
+    g_sink = lcd_id + line + col;
+}
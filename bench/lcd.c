@@ -0,0 +1,267 @@
+/*
+ * Bus time benchmarks of the display operations
+ *
+ * Runs the LCD driver and the redraws of the application on the host
+ * simulation, with the HD44780 model decoding the bus. Each operation is
+ * timed in virtual time, which only moves in the driver delays, so the
+ * result is the time the CPU holds the bus. The model gives the execution
+ * time the datasheet needs for the same transfers and counts the timing
+ * violations. The run fails on a violation or when the display doesn't show
+ * the expected text.
+ *
+ * The application file is included to reach its static functions.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdio.h>
+#include "main.c"
+#include "sim.h"
+#include "hd44780.h"
+
+#undef main
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define LCD_COLUMNS         16
+#define LCD_COUNT           2
+
+#define COUNT(x)            (sizeof(x) / sizeof(x[0]))
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct lcd_bench_t {
+    const char *name;
+    void (*setup)(void);
+    void (*run)(void);
+    // expected text of a display line after the run
+    int lcd, line;
+    const char *text;
+} lcd_bench_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+static const clcd_gpio_t g_lcds_gpio[LCD_COUNT] = {LCD1_PINS, LCD2_PINS};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static hd44780_t g_lcd_models[LCD_COUNT];
+
+static cc_assignment_t g_assignment;
+static option_t g_option, *g_option_list[] = {&g_option};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void str16_set(str16_t *str, const char *text)
+{
+    for (str->size = 0; text[str->size]; str->size++)
+        str->text[str->size] = text[str->size];
+
+    str->text[str->size] = 0;
+}
+
+static void init_run(void)
+{
+    static const clcd_gpio_t lcd1_gpio = LCD1_PINS;
+    static const clcd_gpio_t lcd2_gpio = LCD2_PINS;
+    clcd_init(CLCD_4BIT | CLCD_2LINE, &lcd1_gpio);
+    clcd_init(CLCD_4BIT | CLCD_2LINE, &lcd2_gpio);
+}
+
+static void clear_run(void)
+{
+    clcd_clear(0);
+}
+
+static void cursor_set_run(void)
+{
+    clcd_cursor_set(0, CLCD_LINE2, 0);
+}
+
+static void print_run(void)
+{
+    clcd_cursor_set(0, CLCD_LINE1, 0);
+    clcd_print(0, "0123456789ABCDEF");
+}
+
+static void toggle_setup(void)
+{
+    memset(&g_assignment, 0, sizeof(g_assignment));
+    g_assignment.actuator_id = 1;
+    g_assignment.mode = CC_MODE_TOGGLE;
+    str16_set(&g_assignment.label, "Gain");
+}
+
+static void options_setup(void)
+{
+    toggle_setup();
+    g_assignment.actuator_id = 2;
+    g_assignment.mode = CC_MODE_OPTIONS;
+    g_assignment.list_count = 1;
+    g_assignment.list_items = g_option_list;
+    str16_set(&g_option.label, "Tube");
+}
+
+static void tap_tempo_setup(void)
+{
+    toggle_setup();
+    g_assignment.actuator_id = 3;
+    g_assignment.mode = CC_MODE_TAP_TEMPO;
+    g_assignment.value = 120.0f;
+    g_assignment.min = 20.0f;
+    g_assignment.max = 280.0f;
+    str16_set(&g_assignment.label, "Delay");
+    str16_set(&g_assignment.unit, "BPM");
+}
+
+static void update_lcds_run(void)
+{
+    update_lcds(&g_assignment);
+
+    // the lcd task draws the line
+    while (page_draw_next())
+        ;
+}
+
+static const lcd_bench_t g_benchs[] = {
+    {"clcd_init x2", 0, init_run, 0, 0, ""},
+    {"clcd_clear", 0, clear_run, 0, 0, ""},
+    {"clcd_cursor_set", 0, cursor_set_run, 0, 1, ""},
+    {"clcd_print_16", 0, print_run, 0, 0, "0123456789ABCDEF"},
+    {"update_lcds_toggle", toggle_setup, update_lcds_run, 0, 1, "Gain"},
+    {"update_lcds_options", options_setup, update_lcds_run, 1, 0, "Gain:Tube"},
+    {"update_lcds_tap_tempo", tap_tempo_setup, update_lcds_run, 1, 1, "Delay: 120 BPM"},
+    {"welcome_message", 0, welcome_message, 1, 0, "FOOTSWITCH EXT."},
+    {"clear_all", 0, clear_all, 1, 1, "FOOT #4       P1"},
+};
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// the bench has no file descriptors, the serial port is never opened
+void sim_fd_add(int fd, void (*callback)(int fd))
+{
+    (void) fd;
+    (void) callback;
+}
+
+int sim_poll(int64_t timeout_us)
+{
+    (void) timeout_us;
+    return 0;
+}
+
+int main(void)
+{
+    static const char *op_names[] = HD44780_OP_NAMES;
+    int failed = 0;
+
+    for (int i = 0; i < LCD_COUNT; i++)
+    {
+        hd44780_reset(&g_lcd_models[i]);
+        hd44780_attach(&g_lcd_models[i], &g_lcds_gpio[i]);
+    }
+
+    sim_pin_watch(hd44780_pin);
+
+    printf("%-24s %9s %9s %9s %10s\n", "operation", "bus us", "exec us", "transfers", "violations");
+
+    for (unsigned int i = 0; i < COUNT(g_benchs); i++)
+    {
+        const lcd_bench_t *bench = &g_benchs[i];
+
+        if (bench->setup)
+            bench->setup();
+
+        hd44780_stats_t before[LCD_COUNT];
+        for (int j = 0; j < LCD_COUNT; j++)
+            before[j] = g_lcd_models[j].stats;
+
+        uint64_t start_us = sim_time_us();
+        bench->run();
+        uint64_t bus_us = sim_time_us() - start_us;
+
+        uint64_t exec_us = 0;
+        uint32_t transfers = 0, violations = 0;
+        for (int j = 0; j < LCD_COUNT; j++)
+        {
+            const hd44780_stats_t *stats = &g_lcd_models[j].stats;
+            exec_us += stats->exec_us - before[j].exec_us;
+            violations += stats->violations - before[j].violations;
+
+            for (int op = 0; op < HD44780_OPS; op++)
+                transfers += stats->count[op] - before[j].count[op];
+
+            if (stats->violations != before[j].violations)
+            {
+                printf("    lcd %d: %s at %llu us\n", j + 1, stats->violation,
+                    (unsigned long long) stats->violation_us);
+            }
+        }
+
+        printf("%-24s %9llu %9llu %9u %10u", bench->name, (unsigned long long) bus_us,
+            (unsigned long long) exec_us, transfers, violations);
+
+        // the expected text is padded with the blanks of the line
+        char expected[LCD_COLUMNS + 1], text[LCD_COLUMNS + 1];
+        snprintf(expected, sizeof(expected), "%-*s", LCD_COLUMNS, bench->text);
+        hd44780_line(&g_lcd_models[bench->lcd], bench->line, text, LCD_COLUMNS);
+
+        if (strcmp(text, expected))
+        {
+            printf("  shows |%s|, expected |%s|", text, expected);
+            failed = 1;
+        }
+
+        printf("\n");
+
+        if (violations)
+            failed = 1;
+    }
+
+    printf("\n%-24s %9s\n", "transfer", "count");
+    for (int op = 0; op < HD44780_OPS; op++)
+    {
+        uint32_t count = 0;
+        for (int j = 0; j < LCD_COUNT; j++)
+            count += g_lcd_models[j].stats.count[op];
+
+        if (count)
+            printf("%-24s %9u\n", op_names[op], count);
+    }
+
+    return failed;
+}
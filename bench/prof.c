@@ -0,0 +1,209 @@
+/*
+ * Accounting of the cycle profiler
+ *
+ * Runs the profiler of the firmware (src/prof.c) on the cycle counter of the
+ * virtual chip, with interrupts raised in the middle of the profiled regions.
+ * The work of each region is virtual time, so the cycles it must report are
+ * known: its own time without the regions entered inside it (interrupts,
+ * nested interrupts, delays), and the totals of all the regions add up to
+ * the time that was profiled. The run fails when a region is off.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdio.h>
+#include "chip.h"
+#include "hardware.h"
+#include "delay.h"
+#include "prof.h"
+#include "sim.h"
+
+#undef main
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define MAX_REGIONS         3
+
+#define COUNT(x)            (sizeof(x) / sizeof(x[0]))
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+// an interrupt that takes time_us, raised at_us after the start of the region it preempts
+typedef struct isr_t {
+    int region;
+    uint32_t at_us, time_us;
+    const struct isr_t *nested;
+} isr_t;
+
+typedef struct prof_bench_t {
+    const char *name;
+    // region run by the main loop: time_us of work with a delay_us call of delay_us in the middle
+    int region;
+    uint32_t time_us, delay_us;
+    const isr_t *isr;
+    // own time each region must report, in microseconds
+    struct {
+        int region;
+        uint32_t calls, time_us;
+    } expected[MAX_REGIONS];
+} prof_bench_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+static const char *g_names[PROF_REGIONS] = PROF_NAMES;
+
+static const isr_t g_timer = {PROF_TIMER, 5, 5, 0};
+static const isr_t g_uart = {PROF_UART, 30, 20, 0};
+static const isr_t g_uart_early = {PROF_UART, 10, 20, 0};
+static const isr_t g_uart_timer = {PROF_UART, 30, 20, &g_timer};
+
+static const prof_bench_t g_benchs[] = {
+    {"flat", PROF_CC_PROCESS, 100, 0, 0, {{PROF_CC_PROCESS, 1, 100}}},
+    {"interrupt", PROF_CC_PROCESS, 100, 0, &g_uart, {{PROF_CC_PROCESS, 1, 80}, {PROF_UART, 1, 20}}},
+    {"nested interrupts", PROF_CC_PROCESS, 100, 0, &g_uart_timer,
+        {{PROF_CC_PROCESS, 1, 80}, {PROF_UART, 1, 15}, {PROF_TIMER, 1, 5}}},
+    {"delay", PROF_CLCD_PRINT, 10, 40, 0, {{PROF_CLCD_PRINT, 1, 10}, {PROF_DELAY_US, 1, 40}}},
+    {"interrupt in delay", PROF_CLCD_PRINT, 10, 40, &g_uart_early,
+        {{PROF_CLCD_PRINT, 1, 10}, {PROF_DELAY_US, 1, 20}, {PROF_UART, 1, 20}}},
+    {"across the systick", PROF_CC_PROCESS, 2400, 0, 0, {{PROF_CC_PROCESS, 1, 2400}, {PROF_SYSTICK, 2, 0}}},
+};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static uint32_t cycles_per_us(void)
+{
+    return SystemCoreClock / 1000000;
+}
+
+static void isr_run(void *arg)
+{
+    const isr_t *isr = arg;
+
+    PROF_ENTER(isr->region);
+    if (isr->nested)
+        sim_at(sim_time_us() + isr->nested->at_us, isr_run, (void *) isr->nested);
+    sim_advance(isr->time_us);
+    PROF_EXIT(isr->region);
+}
+
+static int run(const prof_bench_t *bench)
+{
+    // the regions start past a systick, the ones that don't cross the next one end before it
+    sim_advance(1000 - (sim_time_us() % 1000) + (bench->time_us > 1000 ? 500 : 100));
+
+    prof_region_t before[PROF_REGIONS];
+    for (int i = 0; i < PROF_REGIONS; i++)
+        before[i] = *prof_region(i);
+
+    uint64_t start_us = sim_time_us();
+    if (bench->isr)
+        sim_at(start_us + bench->isr->at_us, isr_run, (void *) bench->isr);
+
+    PROF_ENTER(bench->region);
+    sim_advance(bench->time_us / 2);
+    delay_us(bench->delay_us);
+    sim_advance(bench->time_us - (bench->time_us / 2));
+    PROF_EXIT(bench->region);
+
+    uint64_t profiled_cycles = (sim_time_us() - start_us) * cycles_per_us();
+    uint64_t total_cycles = 0;
+    int failed = 0;
+
+    printf("%-20s", bench->name);
+
+    for (int i = 0; i < PROF_REGIONS; i++)
+    {
+        const prof_region_t *region = prof_region(i);
+        uint32_t calls = region->calls - before[i].calls;
+        uint64_t cycles = region->total - before[i].total;
+        total_cycles += cycles;
+
+        uint32_t expected_calls = 0, expected_cycles = 0;
+        for (unsigned int j = 0; j < MAX_REGIONS; j++)
+        {
+            if (bench->expected[j].calls && bench->expected[j].region == i)
+            {
+                expected_calls = bench->expected[j].calls;
+                expected_cycles = bench->expected[j].time_us * cycles_per_us();
+            }
+        }
+
+        if (calls)
+            printf("  %s %u/%llu", g_names[i], calls, (unsigned long long) cycles);
+
+        if (calls != expected_calls || cycles != expected_cycles)
+        {
+            printf(" (%u/%u expected)", expected_calls, expected_cycles);
+            failed = 1;
+        }
+    }
+
+    if (total_cycles != profiled_cycles)
+    {
+        printf("  total %llu of %llu cycles", (unsigned long long) total_cycles,
+            (unsigned long long) profiled_cycles);
+        failed = 1;
+    }
+
+    printf("\n");
+    return failed;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// the bench has no file descriptors
+void sim_fd_add(int fd, void (*callback)(int fd))
+{
+    (void) fd;
+    (void) callback;
+}
+
+int sim_poll(int64_t timeout_us)
+{
+    (void) timeout_us;
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    // the profiler counts the cycles of the systick
+    hw_init();
+
+    printf("%-20s  region calls/cycles\n", "case");
+
+    for (unsigned int i = 0; i < COUNT(g_benchs); i++)
+        failed |= run(&g_benchs[i]);
+
+    return failed;
+}
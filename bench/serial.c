@@ -0,0 +1,333 @@
+/*
+ * Driver enable timing of the serial driver
+ *
+ * Runs the RS-485 driver of the firmware (src/serial.c and the timer that
+ * counts the setup and hold times) on the virtual uart of the simulation,
+ * which the simulation itself replaces with a pty. The bench checks on the wire
+ * that the driver is enabled SERIAL_DE_SETUP_US before the first start bit,
+ * released at most 2 us after SERIAL_DE_HOLD_US past the last stop bit, that
+ * the bytes go out in order and, for frames bigger than the transmit buffer,
+ * that the bus is never released in the middle of the frame. The frames are
+ * sent from a buffer scrubbed right after, as the driver keeps its own copy,
+ * and a frame sent while the previous one waits for room must be counted as
+ * dropped. The run fails on a violation. With LATENCY=1 it also checks that the wire stage of the
+ * latency measure is stamped when the bus is released.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "chip.h"
+#include "serial.h"
+#include "latency.h"
+#include "hardware.h"
+#include "sim.h"
+
+#undef main
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define WIRE_SIZE           1024
+// release time allowed past the hold time, the timer counts whole microseconds
+#define HOLD_MARGIN_NS      2000
+// longest frame at the slowest rate
+#define TIMEOUT_US          100000
+
+#define COUNT(x)            (sizeof(x) / sizeof(x[0]))
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct de_bench_t {
+    const char *name;
+    // size of the first frame, zero sends none
+    uint32_t size;
+    // size of the frame sent in the hold time of the first one (after), or right after it (drop)
+    uint32_t after_size, drop_size;
+} de_bench_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+static const uint32_t g_rates[] = {1000000, 500000, 250000, 115200};
+
+static const de_bench_t g_benchs[] = {
+    {"1 byte", 1, 0, 0},
+    {"16 bytes", 16, 0, 0},
+    {"128 bytes", 128, 0, 0},
+    {"300 bytes", 300, 0, 0},
+    {"sent in hold", 8, 8, 0},
+    {"sent while pending", 300, 0, 8},
+};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static serial_t *g_serial;
+
+// frames as sent, the bytes on the wire are checked against them
+static uint8_t g_frame[WIRE_SIZE], g_after[WIRE_SIZE];
+
+static uint8_t g_wire[WIRE_SIZE];
+static uint32_t g_wire_count;
+static uint64_t g_first_start_ns, g_last_end_ns, g_max_gap_ns;
+
+static uint64_t g_de_on_ns, g_de_off_ns;
+#ifdef LATENCY
+// release time on the firmware clock, which starts with the systick
+static uint32_t g_de_off_us;
+#endif
+static uint32_t g_de_edges;
+static int g_de_level;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void de_pin(int port, int pin, int level)
+{
+    if (port != SERIAL_DE_PORT || pin != SERIAL_DE_PIN || level == g_de_level)
+        return;
+
+    g_de_level = level;
+    if (level)
+    {
+        g_de_on_ns = sim_time_us() * 1000;
+        g_de_edges++;
+    }
+    else
+    {
+        g_de_off_ns = sim_time_us() * 1000;
+#ifdef LATENCY
+        g_de_off_us = hw_time_us();
+#endif
+    }
+}
+
+static void wire_char(uint8_t byte, uint64_t start_ns, uint64_t end_ns)
+{
+    // every character must be sent with the driver enabled
+    if (!g_de_level)
+        printf("    0x%02x sent with the driver disabled at %llu ns\n", byte, (unsigned long long) start_ns);
+
+    if (g_wire_count == 0)
+        g_first_start_ns = start_ns;
+    else if (start_ns - g_last_end_ns > g_max_gap_ns)
+        g_max_gap_ns = start_ns - g_last_end_ns;
+
+    if (g_wire_count < WIRE_SIZE)
+        g_wire[g_wire_count] = byte;
+
+    g_wire_count++;
+    g_last_end_ns = end_ns;
+}
+
+// the driver copies the frame, the buffer is scrubbed once serial_send returns
+static void send(const uint8_t *data, uint32_t size)
+{
+    uint8_t buffer[WIRE_SIZE];
+    memcpy(buffer, data, size);
+
+    serial_data_t sdata = {.data = buffer, .size = size};
+    serial_send(g_serial, &sdata);
+
+    memset(buffer, 0xEE, size);
+}
+
+static int idle(void)
+{
+    return (!g_de_level && serial_tx_pending(g_serial) == 0 &&
+        (Chip_UART_ReadLineStatus(LPC_USART) & UART_LSR_TEMT));
+}
+
+static int run(const de_bench_t *bench, uint32_t rate)
+{
+    for (uint32_t i = 0; i < bench->size; i++)
+        g_frame[i] = i;
+
+    for (uint32_t i = 0; i < WIRE_SIZE; i++)
+        g_after[i] = 0x80 | i;
+
+    g_wire_count = 0;
+    g_max_gap_ns = 0;
+    g_de_edges = 0;
+
+#ifdef LATENCY
+    // a press of switch 1 that goes out with the frame
+    uint32_t edge_us = hw_time_us();
+    uint32_t wire_count = latency_stats(LAT_WIRE)->count, wire_total = latency_stats(LAT_WIRE)->total_us;
+    latency_edge(0, edge_us, edge_us);
+    latency_stage(0, LAT_PICKUP);
+    latency_stage(0, LAT_WRITE);
+#endif
+
+    uint32_t dropped = serial_stats()->dropped;
+    send(g_frame, bench->size);
+
+    uint32_t expected = bench->size;
+    if (bench->drop_size)
+    {
+        // the first frame is still pending, the second one is dropped
+        send(g_after, bench->drop_size);
+    }
+
+    if (bench->after_size)
+    {
+        // wait the last byte in the shift register, the driver waits its stop bit to release the bus
+        uint64_t timeout = sim_time_us() + TIMEOUT_US;
+        while (sim_time_us() < timeout && !(g_wire_count == bench->size - 1 &&
+            !(Chip_UART_ReadLineStatus(LPC_USART) & UART_LSR_TEMT)))
+            sim_advance(1);
+
+        sim_advance(((10 * 1000000) / rate) / 2);
+        send(g_after, bench->after_size);
+        expected += bench->after_size;
+    }
+
+    uint64_t timeout = sim_time_us() + TIMEOUT_US;
+    while (sim_time_us() < timeout && !idle())
+        sim_advance(1);
+
+    uint64_t setup_ns = g_first_start_ns - g_de_on_ns;
+    int64_t hold_ns = (int64_t) g_de_off_ns - (int64_t) g_last_end_ns;
+
+    printf("%-20s %8u %6u %9llu %9lld %9llu", bench->name, rate, g_wire_count,
+        (unsigned long long) setup_ns, (long long) hold_ns, (unsigned long long) g_max_gap_ns);
+
+    int failed = 0;
+
+    if (!idle())
+    {
+        printf("  still sending");
+        failed = 1;
+    }
+
+    if (g_wire_count != expected)
+    {
+        printf("  %u bytes expected", expected);
+        failed = 1;
+    }
+
+    for (uint32_t i = 0; i < g_wire_count && i < WIRE_SIZE && !failed; i++)
+    {
+        uint8_t byte = (i < bench->size ? g_frame[i] : g_after[i - bench->size]);
+        if (g_wire[i] != byte)
+        {
+            printf("  byte %u is 0x%02x, expected 0x%02x", i, g_wire[i], byte);
+            failed = 1;
+        }
+    }
+
+    if (serial_stats()->dropped - dropped != (bench->drop_size ? 1 : 0))
+    {
+        printf("  %u frames dropped", serial_stats()->dropped - dropped);
+        failed = 1;
+    }
+
+    if (g_de_edges != 1)
+    {
+        printf("  driver enabled %u times", g_de_edges);
+        failed = 1;
+    }
+
+    if (setup_ns < SERIAL_DE_SETUP_US * 1000)
+    {
+        printf("  setup too short");
+        failed = 1;
+    }
+
+    if (hold_ns < SERIAL_DE_HOLD_US * 1000 || hold_ns >= SERIAL_DE_HOLD_US * 1000 + HOLD_MARGIN_NS)
+    {
+        printf("  hold out of range");
+        failed = 1;
+    }
+
+#ifdef LATENCY
+    const latency_stats_t *wire = latency_stats(LAT_WIRE);
+    if (wire->count != wire_count + 1 || wire->total_us - wire_total != g_de_off_us - edge_us)
+    {
+        printf("  wire stage not stamped at the release");
+        failed = 1;
+    }
+#endif
+
+    printf("\n");
+
+    // the bus stays free between the cases
+    sim_advance(100);
+
+    return failed;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// the bench has no file descriptors, the serial port is never opened
+void sim_fd_add(int fd, void (*callback)(int fd))
+{
+    (void) fd;
+    (void) callback;
+}
+
+int sim_poll(int64_t timeout_us)
+{
+    (void) timeout_us;
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+#ifdef LATENCY
+    // the latency measures run on the firmware clock
+    hw_init();
+#endif
+
+    sim_pin_watch(de_pin);
+    sim_uart_watch(wire_char);
+
+    printf("%-20s %8s %6s %9s %9s %9s\n", "frame", "baud", "bytes", "setup ns", "hold ns", "gap ns");
+
+    for (unsigned int i = 0; i < COUNT(g_rates); i++)
+    {
+        if (i == 0)
+            g_serial = serial_init(g_rates[i], 0);
+        else
+            serial_baud_rate_set(g_rates[i]);
+
+        for (unsigned int j = 0; j < COUNT(g_benchs); j++)
+            failed |= run(&g_benchs[j], g_rates[i]);
+    }
+
+    return failed;
+}
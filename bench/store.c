@@ -0,0 +1,293 @@
+/*
+ * Option labels restored from the EEPROM
+ *
+ * Writes option lists through the store of the firmware (src/store.c) to the
+ * EEPROM of the virtual chip and restores them as the next power-up does.
+ * The labels of the restored items live in the string pool (src/strpool.c),
+ * so the run prints the bytes each item takes there and in the main RAM next
+ * to what an option item of the cc library takes. It fails when a restored
+ * label differs from the one written, when an assignment that fits is not
+ * restored, or when the pool keeps the labels of an assignment it skipped.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "chip.h"
+#include "hardware.h"
+#include "store.h"
+#include "strpool.h"
+#include "sim.h"
+
+#undef main
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define MAX_LISTS           8
+#define MAX_ITEMS           24
+// an option_t and its pointer in the list of the assignment, on the target
+#define OPTION_ITEM_SIZE    (sizeof(option_t) + sizeof(uint32_t))
+
+#define COUNT(x)            (sizeof(x) / sizeof(x[0]))
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct option_list_t {
+    const char *label;
+    const char *items[MAX_ITEMS];
+} option_list_t;
+
+typedef struct store_bench_t {
+    const char *name;
+    const option_list_t *lists[MAX_LISTS];
+    // assignments expected to be restored, in actuator order
+    int restored[MAX_LISTS];
+} store_bench_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+// option lists of common plugins
+static const option_list_t g_bypass = {"Bypass", {"On", "Off"}};
+static const option_list_t g_sync = {"Sync", {"Off", "On"}};
+static const option_list_t g_shape = {"Shape", {"Sine", "Triangle", "Square", "Saw Up", "Saw Down",
+    "Random"}};
+static const option_list_t g_division = {"Division", {"1/1", "1/2", "1/2.", "1/2T", "1/4", "1/4.",
+    "1/4T", "1/8", "1/8.", "1/8T", "1/16", "1/16T"}};
+static const option_list_t g_preset = {"Preset", {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10",
+    "11", "12", "13", "14", "15", "16"}};
+static const option_list_t g_channel = {"Channel", {"Clean", "Crunch", "Lead", "Bypass"}};
+static const option_list_t g_routing = {"Routing", {"Series", "Parallel", "Left", "Right"}};
+static const option_list_t g_mute = {"Mute", {"Off", "On"}};
+
+// long labels, the second list doesn't fit in the pool after the first one
+static const option_list_t g_long_a = {"Long A", {"Long label A#01", "Long label A#02",
+    "Long label A#03", "Long label A#04", "Long label A#05", "Long label A#06", "Long label A#07",
+    "Long label A#08", "Long label A#09", "Long label A#10", "Long label A#11", "Long label A#12",
+    "Long label A#13", "Long label A#14", "Long label A#15", "Long label A#16", "Long label A#17",
+    "Long label A#18", "Long label A#19", "Long label A#20"}};
+static const option_list_t g_long_b = {"Long B", {"Long label B#01", "Long label B#02",
+    "Long label B#03", "Long label B#04", "Long label B#05", "Long label B#06", "Long label B#07",
+    "Long label B#08", "Long label B#09", "Long label B#10", "Long label B#11", "Long label B#12",
+    "Long label B#13", "Long label B#14", "Long label B#15", "Long label B#16"}};
+
+static const store_bench_t g_benchs[] = {
+    {"plugin options", {&g_bypass, &g_shape, &g_division, &g_preset, &g_channel, &g_routing, &g_mute,
+        &g_sync}, {1, 1, 1, 1, 1, 1, 1, 1}},
+    {"pool full", {&g_long_a, &g_long_b, &g_bypass}, {1, 0, 1}},
+};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static cc_assignment_t *g_assignments[ACTUATORS_COUNT];
+static cc_assignment_t g_assignment[MAX_LISTS];
+static option_t g_option[MAX_LISTS][MAX_ITEMS];
+static option_t *g_option_list[MAX_LISTS][MAX_ITEMS];
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void str16_set(str16_t *str, const char *text)
+{
+    str->size = strlen(text);
+    memcpy(str->text, text, str->size + 1);
+}
+
+static int list_count(const option_list_t *list)
+{
+    int count = 0;
+    while (count < MAX_ITEMS && list->items[count])
+        count++;
+
+    return count;
+}
+
+// assigns the option lists to the first actuators and writes them to the EEPROM
+static void assign(const store_bench_t *bench)
+{
+    memset(g_assignments, 0, sizeof(g_assignments));
+
+    for (int i = 0; i < MAX_LISTS && bench->lists[i]; i++)
+    {
+        const option_list_t *list = bench->lists[i];
+        cc_assignment_t *assignment = &g_assignment[i];
+
+        memset(assignment, 0, sizeof(*assignment));
+        assignment->id = i;
+        assignment->actuator_id = i;
+        assignment->mode = CC_MODE_OPTIONS;
+        str16_set(&assignment->label, list->label);
+        assignment->list_count = list_count(list);
+        assignment->list_items = g_option_list[i];
+
+        for (int j = 0; j < assignment->list_count; j++)
+        {
+            str16_set(&g_option[i][j].label, list->items[j]);
+            g_option[i][j].value = j;
+            g_option_list[i][j] = &g_option[i][j];
+        }
+
+        g_assignments[i] = assignment;
+    }
+
+    uint32_t next;
+    store_changed();
+    while ((next = store_process()) != 0)
+        sim_advance(next * 1000);
+}
+
+// bytes of the distinct labels of the lists expected to be restored, as the pool keeps them
+static uint32_t pool_expected(const store_bench_t *bench)
+{
+    const char *labels[MAX_LISTS * MAX_ITEMS];
+    int count = 0;
+    uint32_t size = 0;
+
+    for (int i = 0; i < MAX_LISTS && bench->lists[i]; i++)
+    {
+        if (!bench->restored[i])
+            continue;
+
+        for (int j = 0; j < list_count(bench->lists[i]); j++)
+        {
+            const char *label = bench->lists[i]->items[j];
+            int k = 0;
+            while (k < count && strcmp(labels[k], label) != 0)
+                k++;
+
+            if (k < count)
+                continue;
+
+            labels[count++] = label;
+            size += strlen(label) + 2;
+        }
+    }
+
+    return size;
+}
+
+static int run(const store_bench_t *bench)
+{
+    int failed = 0, items = 0, restored = 0;
+
+    assign(bench);
+
+    // power-up: nothing is assigned until the host sends the assignments
+    memset(g_assignments, 0, sizeof(g_assignments));
+    store_restore();
+
+    for (int i = 0; i < MAX_LISTS && bench->lists[i]; i++)
+    {
+        const option_list_t *list = bench->lists[i];
+
+        if (store_provisional(i) != bench->restored[i])
+        {
+            printf("%-16s  %s %s\n", bench->name, list->label,
+                bench->restored[i] ? "not restored" : "restored over the pool size");
+            failed = 1;
+            continue;
+        }
+
+        if (!bench->restored[i])
+            continue;
+
+        restored++;
+        for (int j = 0; j < list_count(list); j++, items++)
+        {
+            uint8_t size;
+            const char *label = store_item_label(i, j, &size);
+            if (size != strlen(list->items[j]) || memcmp(label, list->items[j], size) != 0)
+            {
+                printf("%-16s  %s item %d is \"%.*s\", \"%s\" expected\n", bench->name, list->label,
+                    j, size, label, list->items[j]);
+                failed = 1;
+            }
+        }
+    }
+
+    // tenths of a byte
+    uint32_t pool = strpool_used();
+    uint32_t main_size = sizeof(strpool_t) + sizeof(float);
+    uint32_t pool_size = items ? ((pool * 10) + (items / 2)) / items : 0;
+    uint32_t total = (main_size * 10) + pool_size;
+
+    printf("%-16s  %5d %5d %7u %7u %5u.%u %5u.%u %5u\n", bench->name, restored, items,
+        (unsigned int) OPTION_ITEM_SIZE, main_size, pool_size / 10, pool_size % 10, total / 10,
+        total % 10, pool);
+
+    if (pool != pool_expected(bench))
+    {
+        printf("%-16s  pool %u bytes, %u expected\n", "", pool, pool_expected(bench));
+        failed = 1;
+    }
+
+    return failed;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// the bench has no file descriptors
+void sim_fd_add(int fd, void (*callback)(int fd))
+{
+    (void) fd;
+    (void) callback;
+}
+
+int sim_poll(int64_t timeout_us)
+{
+    (void) timeout_us;
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    // the store waits for the assignments to settle on the uptime
+    hw_init();
+    sim_eeprom_load(0);
+    store_init(g_assignments, ACTUATORS_COUNT);
+
+    // bytes per item: an option item of the cc library, then a restored item in the main RAM,
+    // its share of the pool and both
+    printf("%-16s  %5s %5s %7s %7s %7s %7s %5s\n", "case", "lists", "items", "cc", "main", "pool",
+        "total", "pool");
+
+    for (unsigned int i = 0; i < COUNT(g_benchs); i++)
+        failed |= run(&g_benchs[i]);
+
+    return failed;
+}
@@ -0,0 +1,82 @@
+/*
+ * Analog input in virtual time
+ *
+ * The bursts come at ADC_BURST_RATE as the 16-bit timer starts them, the
+ * conversions of a burst read the source set by the replay (heel down if
+ * there is none) and their sum goes to the callback.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "adc.h"
+#include "sim.h"
+#include "sched.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define BURST_PERIOD        (1000000 / ADC_BURST_RATE)
+// time between the conversions of a burst
+#define CONVERSION_TIME     (1000000 / ADC_SAMPLE_RATE)
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static void (*g_callback)(uint32_t sum);
+static int (*g_source)(uint64_t time_us);
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// runs at the end of the burst, in the interrupt of the last conversion
+static void burst(void *arg)
+{
+    (void) arg;
+    sched_irq_entry();
+
+    uint64_t end = sim_time_us();
+    uint32_t sum = 0;
+
+    for (int i = ADC_OVERSAMPLE; i > 0; i--)
+    {
+        int data = (g_source ? g_source(end - i * CONVERSION_TIME) : 0);
+        sum += (data < 0 ? 0 : data > 1023 ? 1023 : data);
+    }
+
+    g_callback(sum);
+    sim_at(end + BURST_PERIOD, burst, 0);
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+void adc_init(void (*callback)(uint32_t sum))
+{
+    g_callback = callback;
+    sim_at(sim_time_us() + BURST_PERIOD + ADC_OVERSAMPLE * CONVERSION_TIME, burst, 0);
+}
+
+void sim_adc_source(int (*source)(uint64_t time_us))
+{
+    g_source = source;
+}
@@ -0,0 +1,581 @@
+/*
+ * Virtual LPC11U24
+ *
+ * Virtual clock, GPIO pins, pin interrupts, SysTick, sleep and the IAP
+ * calls (unique id and EEPROM) used by the firmware. Interrupt handlers run
+ * when the virtual time moves forward: while the firmware sleeps or waits in
+ * a delay. The code takes no virtual time, but the entry and the return of
+ * an exception that wakes up the cpu do.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chip.h"
+#include "sim.h"
+#include "hardware.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define PORTS               2
+#define PINS                32
+#define PIN_INTS            4
+
+// time the IAP takes to program an EEPROM page (in microseconds)
+#define EEPROM_PAGE_TIME    3000
+// time the entry, or the return, of an exception that wakes up the cpu takes: 16 cycles of the
+// Cortex-M0 at 48 MHz and the wakeup, rounded up to the resolution of the virtual clock (in
+// microseconds)
+#define EXCEPTION_TIME      1
+
+// IAP status codes
+#define IAP_SUCCESS         0
+#define IAP_INVALID_COMMAND 1
+#define IAP_SRC_ADDR_ERROR  2
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct pin_t {
+    uint8_t output, state, driven, level;
+} pin_t;
+
+typedef struct pin_int_t {
+    int8_t port, pin;
+    uint8_t high, low, enabled;
+} pin_int_t;
+
+typedef struct event_t {
+    uint64_t time_us;
+    sim_event_cb_t callback;
+    void *arg;
+} event_t;
+
+
+/*
+****************************************************************************************************
+*       GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+SysTick_Type sim_systick;
+SCB_Type sim_scb;
+uint32_t SystemCoreClock = 48000000;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static pin_t g_pins[PORTS][PINS];
+static pin_int_t g_pin_ints[PIN_INTS];
+static void (*g_pin_watch)(int port, int pin, int level);
+
+static uint64_t g_time_us;
+static int g_sleeping;
+static event_t g_events[SIM_MAX_EVENTS];
+static int g_events_count;
+
+// virtual time runs at speed times the wall clock, zero runs as fast as possible
+static double g_speed = 1.0;
+static uint64_t g_wall_origin, g_time_origin;
+
+static uint8_t g_eeprom[EEPROM_SIZE];
+
+// interrupts of the peripheral models, all of them start disabled as in the NVIC
+static uint32_t g_irq_enabled;
+static void (*g_irq_pending[32])(void);
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// firmware interrupt handlers
+void SysTick_Handler(void);
+void FLEX_INT0_IRQHandler(void);
+void FLEX_INT1_IRQHandler(void);
+void FLEX_INT2_IRQHandler(void);
+void FLEX_INT3_IRQHandler(void);
+
+static void (* const g_pin_handlers[PIN_INTS])(void) = {
+    FLEX_INT0_IRQHandler, FLEX_INT1_IRQHandler, FLEX_INT2_IRQHandler, FLEX_INT3_IRQHandler,
+};
+
+static uint64_t wall_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void systick_update(void)
+{
+    if (sim_systick.LOAD == 0)
+        return;
+
+    uint32_t us = g_time_us % 1000;
+    sim_systick.VAL = sim_systick.LOAD - (us * (SystemCoreClock / 1000000));
+}
+
+// runs an interrupt handler of the firmware, the ones that run in a delay cost nothing so the
+// timing of the peripheral models stays exact
+static void exception(void (*handler)(void))
+{
+    uint32_t time = (g_sleeping ? EXCEPTION_TIME : 0);
+
+    g_time_us += time;
+    systick_update();
+    handler();
+    g_time_us += time;
+    systick_update();
+}
+
+// earliest of the next systick and the pending events, -1 for the systick
+static int next_event(uint64_t *time_us)
+{
+    int next = -2;
+    *time_us = UINT64_MAX;
+
+    if (sim_systick.LOAD)
+    {
+        *time_us = ((g_time_us / 1000) + 1) * 1000;
+        next = -1;
+    }
+
+    for (int i = 0; i < g_events_count; i++)
+    {
+        if (g_events[i].time_us < *time_us)
+        {
+            *time_us = g_events[i].time_us;
+            next = i;
+        }
+    }
+
+    return next;
+}
+
+static void advance_to(uint64_t target_us)
+{
+    uint64_t time_us;
+    int next;
+
+    while ((next = next_event(&time_us)) != -2 && time_us <= target_us)
+    {
+        if (time_us > g_time_us)
+            g_time_us = time_us;
+
+        systick_update();
+
+        if (next == -1)
+        {
+            exception(SysTick_Handler);
+        }
+        else
+        {
+            event_t event = g_events[next];
+            g_events[next] = g_events[--g_events_count];
+            event.callback(event.arg);
+        }
+    }
+
+    if (target_us > g_time_us)
+        g_time_us = target_us;
+
+    systick_update();
+}
+
+// virtual time that corresponds to the current wall clock
+static uint64_t wall_to_time(void)
+{
+    return g_time_origin + (uint64_t) ((wall_us() - g_wall_origin) * g_speed);
+}
+
+// the IAP parameters are 32-bit, the simulator is linked without PIE so the static buffers
+// the firmware passes have 32-bit addresses
+static uint8_t *iap_pointer(unsigned int address, unsigned int size)
+{
+    extern char __executable_start[], _end[];
+
+    uint8_t *ptr = (uint8_t *) (uintptr_t) address;
+    if (ptr < (uint8_t *) __executable_start || ptr + size > (uint8_t *) _end)
+    {
+        fprintf(stderr, "sim: IAP buffer 0x%08x is not a static variable\n", address);
+        abort();
+    }
+
+    return ptr;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+uint64_t sim_time_us(void)
+{
+    return g_time_us;
+}
+
+void sim_advance(uint32_t us)
+{
+    advance_to(g_time_us + us);
+}
+
+int sim_at(uint64_t time_us, sim_event_cb_t callback, void *arg)
+{
+    if (g_events_count >= SIM_MAX_EVENTS)
+        return -1;
+
+    g_events[g_events_count].time_us = time_us;
+    g_events[g_events_count].callback = callback;
+    g_events[g_events_count].arg = arg;
+    g_events_count++;
+
+    return 0;
+}
+
+void sim_clock_pacing(double speed)
+{
+    g_speed = speed;
+    g_wall_origin = wall_us();
+    g_time_origin = g_time_us;
+}
+
+// catches up with the wall clock before handling an input
+void sim_clock_sync(void)
+{
+    if (g_speed <= 0)
+        return;
+
+    uint64_t now = wall_to_time();
+    if (now > g_time_us)
+        advance_to(now);
+}
+
+void sim_pin_drive(int port, int pin, int level)
+{
+    pin_t *p = &g_pins[port][pin];
+    int changed = (!p->driven || p->level != level);
+
+    p->driven = 1;
+    p->level = level;
+
+    if (!changed || p->output)
+        return;
+
+    for (int i = 0; i < PIN_INTS; i++)
+    {
+        pin_int_t *pin_int = &g_pin_ints[i];
+        if (pin_int->port == port && pin_int->pin == pin && pin_int->enabled &&
+            ((level && pin_int->high) || (!level && pin_int->low)))
+        {
+            exception(g_pin_handlers[i]);
+        }
+    }
+}
+
+int sim_pin_level(int port, int pin)
+{
+    pin_t *p = &g_pins[port][pin];
+    return (p->output ? p->state : p->level);
+}
+
+void sim_pin_watch(void (*callback)(int port, int pin, int level))
+{
+    g_pin_watch = callback;
+}
+
+int sim_eeprom_load(const char *filename)
+{
+    memset(g_eeprom, 0xFF, sizeof(g_eeprom));
+    if (!filename)
+        return 0;
+
+    FILE *fp = fopen(filename, "rb");
+    if (!fp)
+        return -1;
+
+    size_t size = fread(g_eeprom, 1, sizeof(g_eeprom), fp);
+    fclose(fp);
+
+    return (int) size;
+}
+
+int sim_eeprom_save(const char *filename)
+{
+    FILE *fp = fopen(filename, "wb");
+    if (!fp)
+        return -1;
+
+    size_t size = fwrite(g_eeprom, 1, sizeof(g_eeprom), fp);
+    fclose(fp);
+
+    return (size == sizeof(g_eeprom) ? 0 : -1);
+}
+
+void Chip_SystemInit(void)
+{
+    for (int i = 0; i < PIN_INTS; i++)
+        g_pin_ints[i].port = -1;
+
+    if (g_wall_origin == 0)
+        sim_clock_pacing(g_speed);
+}
+
+void SystemCoreClockUpdate(void)
+{
+}
+
+uint32_t Chip_Clock_GetSystemClockRate(void)
+{
+    return SystemCoreClock;
+}
+
+uint32_t Chip_Clock_GetMainClockRate(void)
+{
+    return SystemCoreClock;
+}
+
+void Chip_Clock_EnablePeriphClock(CHIP_SYSCTL_CLOCK_T clk)
+{
+    (void) clk;
+}
+
+void Chip_IOCON_PinMuxSet(LPC_IOCON_T *pIOCON, uint8_t port, uint8_t pin, uint32_t modefunc)
+{
+    (void) pIOCON;
+    (void) port;
+    (void) pin;
+    (void) modefunc;
+}
+
+void Chip_GPIO_Init(LPC_GPIO_T *pGPIO)
+{
+    (void) pGPIO;
+}
+
+void Chip_GPIO_SetPinDIR(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin, bool output)
+{
+    (void) pGPIO;
+    g_pins[port][pin].output = output;
+}
+
+void Chip_GPIO_SetPinDIROutput(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin)
+{
+    Chip_GPIO_SetPinDIR(pGPIO, port, pin, true);
+}
+
+void Chip_GPIO_SetPinDIRInput(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin)
+{
+    Chip_GPIO_SetPinDIR(pGPIO, port, pin, false);
+}
+
+void Chip_GPIO_SetPinState(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin, bool setting)
+{
+    (void) pGPIO;
+
+    pin_t *p = &g_pins[port][pin];
+    int changed = (p->state != setting);
+    p->state = setting;
+
+    if (changed && p->output && g_pin_watch)
+        g_pin_watch(port, pin, setting);
+}
+
+void Chip_GPIO_SetPinToggle(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin)
+{
+    Chip_GPIO_SetPinState(pGPIO, port, pin, !g_pins[port][pin].state);
+}
+
+bool Chip_GPIO_GetPinState(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin)
+{
+    (void) pGPIO;
+    return sim_pin_level(port, pin);
+}
+
+void Chip_SYSCTL_SetPinInterrupt(uint32_t intno, uint8_t port, uint8_t pin)
+{
+    if (intno >= PIN_INTS)
+        return;
+
+    g_pin_ints[intno].port = port;
+    g_pin_ints[intno].pin = pin;
+}
+
+void Chip_PININT_SetPinModeEdge(LPC_PININT_T *pPININT, uint32_t pins)
+{
+    (void) pPININT;
+    (void) pins;
+}
+
+void Chip_PININT_EnableIntHigh(LPC_PININT_T *pPININT, uint32_t pins)
+{
+    (void) pPININT;
+    for (int i = 0; i < PIN_INTS; i++)
+    {
+        if (pins & PININTCH(i))
+            g_pin_ints[i].high = 1;
+    }
+}
+
+void Chip_PININT_EnableIntLow(LPC_PININT_T *pPININT, uint32_t pins)
+{
+    (void) pPININT;
+    for (int i = 0; i < PIN_INTS; i++)
+    {
+        if (pins & PININTCH(i))
+            g_pin_ints[i].low = 1;
+    }
+}
+
+void Chip_PININT_ClearIntStatus(LPC_PININT_T *pPININT, uint32_t pins)
+{
+    (void) pPININT;
+    (void) pins;
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn >= PIN_INT0_IRQn && IRQn < PIN_INT0_IRQn + PIN_INTS)
+        g_pin_ints[IRQn - PIN_INT0_IRQn].enabled = 1;
+
+    g_irq_enabled |= (1UL << IRQn);
+
+    // an interrupt raised while it was disabled runs now
+    void (*handler)(void) = g_irq_pending[IRQn];
+    g_irq_pending[IRQn] = 0;
+    if (handler)
+        exception(handler);
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    g_irq_enabled &= ~(1UL << IRQn);
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+    g_irq_pending[IRQn] = 0;
+}
+
+// all the interrupts of the models have the same priority, none preempts another
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    (void) IRQn;
+    (void) priority;
+}
+
+void sim_irq(int irq, void (*handler)(void))
+{
+    if (g_irq_enabled & (1UL << irq))
+        exception(handler);
+    else
+        g_irq_pending[irq] = handler;
+}
+
+uint32_t SysTick_Config(uint32_t ticks)
+{
+    sim_systick.LOAD = ticks - 1;
+    sim_systick.CTRL = 7;
+    systick_update();
+
+    return 0;
+}
+
+// sleeps until the next interrupt: the systick, a pending event or an input
+void Chip_PMU_SleepState(LPC_PMU_T *pPMU)
+{
+    (void) pPMU;
+
+    uint64_t next;
+    if (next_event(&next) == -2)
+        next = g_time_us + 1000;
+
+    int64_t wait_us = 0;
+    if (g_speed > 0)
+        wait_us = (int64_t) (((int64_t) next - (int64_t) wall_to_time()) / g_speed);
+
+    // an input woke up the cpu
+    if (sim_poll(wait_us > 0 ? wait_us : 0) > 0)
+        return;
+
+    g_sleeping = 1;
+    advance_to(next);
+    g_sleeping = 0;
+}
+
+void iap_entry(unsigned int cmd_param[], unsigned int status_result[])
+{
+    unsigned int address = cmd_param[1], size = cmd_param[3];
+
+    switch (cmd_param[0])
+    {
+        // read the unique id
+        case 58:
+            status_result[0] = IAP_SUCCESS;
+            status_result[1] = 0x53494D00;
+            status_result[2] = 0x464F4F54;
+            status_result[3] = 0x00000001;
+            status_result[4] = 0x00000000;
+            break;
+
+        // write EEPROM
+        case 61:
+            if (address + size > EEPROM_SIZE)
+            {
+                status_result[0] = IAP_SRC_ADDR_ERROR;
+                break;
+            }
+
+            memcpy(&g_eeprom[address], iap_pointer(cmd_param[2], size), size);
+            sim_advance(((size + EEPROM_PAGE - 1) / EEPROM_PAGE) * EEPROM_PAGE_TIME);
+            status_result[0] = IAP_SUCCESS;
+            break;
+
+        // read EEPROM
+        case 62:
+            if (address + size > EEPROM_SIZE)
+            {
+                status_result[0] = IAP_SRC_ADDR_ERROR;
+                break;
+            }
+
+            memcpy(iap_pointer(cmd_param[2], size), &g_eeprom[address], size);
+            status_result[0] = IAP_SUCCESS;
+            break;
+
+        default:
+            status_result[0] = IAP_INVALID_COMMAND;
+            break;
+    }
+}
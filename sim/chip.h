@@ -0,0 +1,178 @@
+#ifndef CHIP_H
+#define CHIP_H
+
+/*
+ * Host stand-in for the LPCOpen chip header
+ *
+ * Provides the subset of the LPC11U24 peripherals used by the firmware on
+ * top of the virtual clock and pins of the simulator (see chip.c).
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ring_buffer.h"
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+#define LPC_GPIO            ((LPC_GPIO_T *) 0)
+#define LPC_IOCON           ((LPC_IOCON_T *) 0)
+#define LPC_PININT          ((LPC_PININT_T *) 0)
+#define LPC_PMU             ((LPC_PMU_T *) 0)
+#define LPC_USART           (&sim_usart)
+#define LPC_TIMER32_0       ((LPC_TIMER_T *) 0)
+
+#define SysTick             (&sim_systick)
+#define SCB                 (&sim_scb)
+#define SCB_ICSR_PENDSTSET_Msk  (1UL << 26)
+
+#define FUNC0               0x0
+#define FUNC1               0x1
+#define FUNC2               0x2
+#define FUNC3               0x3
+#define PININTCH(ch)        (1 << (ch))
+
+#define UART_LCR_WLEN8      (3 << 0)
+#define UART_LCR_SBS_1BIT   (0 << 2)
+#define UART_FCR_FIFO_EN    (1 << 0)
+#define UART_FCR_TRG_LEV2   (2 << 6)
+#define UART_IER_RBRINT     (1 << 0)
+#define UART_IER_THREINT    (1 << 1)
+#define UART_IER_RLSINT     (1 << 2)
+#define UART_LSR_RDR        (1 << 0)
+#define UART_LSR_THRE       (1 << 5)
+#define UART_LSR_TEMT       (1 << 6)
+#define UART_LOAD_DLL(div)  ((div) & 0xFF)
+#define UART_LOAD_DLM(div)  (((div) >> 8) & 0xFF)
+#define UART_FDR_DIVADDVAL(n)   ((n) & 0xF)
+#define UART_FDR_MULVAL(n)  (((n) << 4) & 0xF0)
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct LPC_GPIO_T LPC_GPIO_T;
+typedef struct LPC_IOCON_T LPC_IOCON_T;
+typedef struct LPC_PININT_T LPC_PININT_T;
+typedef struct LPC_PMU_T LPC_PMU_T;
+typedef struct LPC_TIMER_T LPC_TIMER_T;
+
+typedef struct LPC_USART_T {
+    volatile uint32_t FDR;
+} LPC_USART_T;
+
+typedef struct SysTick_Type {
+    volatile uint32_t CTRL, LOAD, VAL, CALIB;
+} SysTick_Type;
+
+typedef struct SCB_Type {
+    volatile uint32_t ICSR;
+} SCB_Type;
+
+typedef enum {
+    PIN_INT0_IRQn = 0,
+    PIN_INT1_IRQn, PIN_INT2_IRQn, PIN_INT3_IRQn,
+    TIMER_32_0_IRQn = 18,
+    UART0_IRQn = 21,
+} IRQn_Type;
+
+typedef enum {
+    SYSCTL_CLOCK_GPIO = 6,
+    SYSCTL_CLOCK_PINT = 19,
+} CHIP_SYSCTL_CLOCK_T;
+
+
+/*
+****************************************************************************************************
+*       GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+extern SysTick_Type sim_systick;
+extern SCB_Type sim_scb;
+extern LPC_USART_T sim_usart;
+extern uint32_t SystemCoreClock;
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+void Chip_SystemInit(void);
+void SystemCoreClockUpdate(void);
+uint32_t Chip_Clock_GetSystemClockRate(void);
+uint32_t Chip_Clock_GetMainClockRate(void);
+void Chip_Clock_EnablePeriphClock(CHIP_SYSCTL_CLOCK_T clk);
+void Chip_IOCON_PinMuxSet(LPC_IOCON_T *pIOCON, uint8_t port, uint8_t pin, uint32_t modefunc);
+
+void Chip_GPIO_Init(LPC_GPIO_T *pGPIO);
+void Chip_GPIO_SetPinDIR(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin, bool output);
+void Chip_GPIO_SetPinDIROutput(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin);
+void Chip_GPIO_SetPinDIRInput(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin);
+void Chip_GPIO_SetPinState(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin, bool setting);
+void Chip_GPIO_SetPinToggle(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin);
+bool Chip_GPIO_GetPinState(LPC_GPIO_T *pGPIO, uint8_t port, uint8_t pin);
+
+void Chip_SYSCTL_SetPinInterrupt(uint32_t intno, uint8_t port, uint8_t pin);
+void Chip_PININT_SetPinModeEdge(LPC_PININT_T *pPININT, uint32_t pins);
+void Chip_PININT_EnableIntHigh(LPC_PININT_T *pPININT, uint32_t pins);
+void Chip_PININT_EnableIntLow(LPC_PININT_T *pPININT, uint32_t pins);
+void Chip_PININT_ClearIntStatus(LPC_PININT_T *pPININT, uint32_t pins);
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+
+// transmit side of the uart and the match of the 32-bit timer 0 (uart.c)
+void Chip_UART_Init(LPC_USART_T *pUART);
+void Chip_UART_ConfigData(LPC_USART_T *pUART, uint32_t config);
+void Chip_UART_SetupFIFOS(LPC_USART_T *pUART, uint32_t fcr);
+void Chip_UART_TXEnable(LPC_USART_T *pUART);
+void Chip_UART_IntEnable(LPC_USART_T *pUART, uint32_t intMask);
+void Chip_UART_IntDisable(LPC_USART_T *pUART, uint32_t intMask);
+void Chip_UART_EnableDivisorAccess(LPC_USART_T *pUART);
+void Chip_UART_DisableDivisorAccess(LPC_USART_T *pUART);
+void Chip_UART_SetDivisorLatches(LPC_USART_T *pUART, uint8_t dll, uint8_t dlm);
+uint32_t Chip_UART_ReadLineStatus(LPC_USART_T *pUART);
+void Chip_UART_SendByte(LPC_USART_T *pUART, uint8_t data);
+void Chip_UART_TXIntHandlerRB(LPC_USART_T *pUART, RINGBUFF_T *pRB);
+void Chip_UART_RXIntHandlerRB(LPC_USART_T *pUART, RINGBUFF_T *pRB);
+int Chip_UART_ReadRB(LPC_USART_T *pUART, RINGBUFF_T *pRB, void *data, int bytes);
+
+void Chip_TIMER_Init(LPC_TIMER_T *pTMR);
+void Chip_TIMER_Reset(LPC_TIMER_T *pTMR);
+void Chip_TIMER_Enable(LPC_TIMER_T *pTMR);
+void Chip_TIMER_Disable(LPC_TIMER_T *pTMR);
+void Chip_TIMER_SetMatch(LPC_TIMER_T *pTMR, int8_t matchnum, uint32_t matchval);
+void Chip_TIMER_MatchEnableInt(LPC_TIMER_T *pTMR, int8_t matchnum);
+void Chip_TIMER_ResetOnMatchEnable(LPC_TIMER_T *pTMR, int8_t matchnum);
+bool Chip_TIMER_MatchPending(LPC_TIMER_T *pTMR, int8_t matchnum);
+void Chip_TIMER_ClearMatch(LPC_TIMER_T *pTMR, int8_t matchnum);
+
+uint32_t SysTick_Config(uint32_t ticks);
+void Chip_PMU_SleepState(LPC_PMU_T *pPMU);
+
+void iap_entry(unsigned int cmd_param[], unsigned int status_result[]);
+
+// interrupts are only delivered while the firmware sleeps or waits, nothing to mask
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t mask) { (void) mask; }
+
+#endif
@@ -0,0 +1,34 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "delay.h"
+#include "sim.h"
+#include "prof.h"
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// the virtual time moves forward, the interrupts that fall in the delay are handled
+void delay_init(void)
+{
+}
+
+void delay_us(uint32_t us)
+{
+    if (us == 0) return;
+    PROF_ENTER(PROF_DELAY_US);
+    sim_advance(us);
+    PROF_EXIT(PROF_DELAY_US);
+}
+
+void delay_ms(uint32_t ms)
+{
+    sim_advance(ms * 1000);
+}
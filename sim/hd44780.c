@@ -0,0 +1,339 @@
+/*
+ * HD44780 controller model
+ *
+ * Decodes the bus at the enable edges of each attached display, in the 8 bits
+ * interface after reset and in the 4 bits interface after a function set
+ * selects it. The datasheet timing is enforced in virtual time: transfers
+ * while the display is busy, short enable pulses and short enable cycles are
+ * counted as violations, and the writes issued while busy are lost as on the
+ * real controller. Busy flag and RAM reads drive the data pins.
+ *
+ * DDRAM, CGRAM, address counter, entry mode and display on/off are modeled,
+ * shifts are not. The stats count each kind of transfer and the execution
+ * time the datasheet gives for it.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <string.h>
+#include "hd44780.h"
+#include "sim.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define CMD_CLEAR_DISPLAY   0x01
+#define CMD_RETURN_HOME     0x02
+#define CMD_ENTRY_MODE_SET  0x04
+#define CMD_DISPLAY_CONTROL 0x08
+#define CMD_CURSOR_SHIFT    0x10
+#define CMD_FUNCTION_SET    0x20
+#define CMD_SET_CGRAM_ADDR  0x40
+#define CMD_SET_DDRAM_ADDR  0x80
+
+#define BUSY_FLAG           0x80
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static hd44780_t *g_displays[HD44780_MAX_DISPLAYS];
+static int g_displays_count;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void violation(hd44780_t *lcd, const char *what)
+{
+    lcd->stats.violations++;
+    lcd->stats.violation = what;
+    lcd->stats.violation_us = sim_time_us();
+}
+
+static void execute(hd44780_t *lcd, int op, uint32_t exec_us)
+{
+    lcd->stats.count[op]++;
+    lcd->stats.exec_us += exec_us;
+    lcd->busy_until_us = sim_time_us() + exec_us;
+}
+
+static void advance_address(hd44780_t *lcd)
+{
+    lcd->address = (lcd->address + (lcd->increment ? 1 : -1)) & 0x7F;
+}
+
+static void command(hd44780_t *lcd, uint8_t value)
+{
+    if (value & CMD_SET_DDRAM_ADDR)
+    {
+        lcd->address = value & 0x7F;
+        lcd->cgram_selected = 0;
+        execute(lcd, HD44780_OP_DDRAM_ADDRESS, HD44780_EXEC_US);
+    }
+    else if (value & CMD_SET_CGRAM_ADDR)
+    {
+        lcd->address = value & 0x3F;
+        lcd->cgram_selected = 1;
+        execute(lcd, HD44780_OP_CGRAM_ADDRESS, HD44780_EXEC_US);
+    }
+    else if (value & CMD_FUNCTION_SET)
+    {
+        lcd->four_bit = !(value & 0x10);
+        lcd->lines = (value & 0x08) ? 2 : 1;
+        lcd->nibble_pending = 0;
+
+        // the first function sets of the initialization by instruction take longer
+        uint32_t exec_us = HD44780_EXEC_US;
+        if (lcd->init_steps == 0)
+            exec_us = HD44780_INIT1_US;
+        else if (lcd->init_steps == 1)
+            exec_us = HD44780_INIT2_US;
+
+        if (lcd->init_steps < 2)
+            lcd->init_steps++;
+
+        execute(lcd, HD44780_OP_FUNCTION_SET, exec_us);
+    }
+    else if (value & CMD_CURSOR_SHIFT)
+    {
+        execute(lcd, HD44780_OP_SHIFT, HD44780_EXEC_US);
+    }
+    else if (value & CMD_DISPLAY_CONTROL)
+    {
+        lcd->display_on = (value & 0x04) ? 1 : 0;
+        lcd->changes++;
+        execute(lcd, HD44780_OP_DISPLAY_CONTROL, HD44780_EXEC_US);
+    }
+    else if (value & CMD_ENTRY_MODE_SET)
+    {
+        lcd->increment = (value & 0x02) ? 1 : 0;
+        execute(lcd, HD44780_OP_ENTRY_MODE, HD44780_EXEC_US);
+    }
+    else if (value & CMD_RETURN_HOME)
+    {
+        lcd->address = 0;
+        lcd->cgram_selected = 0;
+        execute(lcd, HD44780_OP_HOME, HD44780_HOME_US);
+    }
+    else if (value & CMD_CLEAR_DISPLAY)
+    {
+        memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+        lcd->address = 0;
+        lcd->increment = 1;
+        lcd->cgram_selected = 0;
+        lcd->changes++;
+        execute(lcd, HD44780_OP_CLEAR, HD44780_CLEAR_US);
+    }
+}
+
+static void write_data(hd44780_t *lcd, uint8_t value)
+{
+    if (lcd->cgram_selected)
+    {
+        lcd->cgram[lcd->address & 0x3F] = value;
+    }
+    else
+    {
+        if (lcd->ddram[lcd->address] != value)
+            lcd->changes++;
+
+        lcd->ddram[lcd->address] = value;
+    }
+
+    advance_address(lcd);
+    execute(lcd, HD44780_OP_WRITE, HD44780_EXEC_US + HD44780_ADD_US);
+}
+
+static uint8_t read_data(hd44780_t *lcd)
+{
+    uint8_t value = (lcd->cgram_selected ? lcd->cgram[lcd->address & 0x3F] : lcd->ddram[lcd->address]);
+
+    advance_address(lcd);
+    execute(lcd, HD44780_OP_READ, HD44780_EXEC_US + HD44780_ADD_US);
+
+    return value;
+}
+
+// the display drives D7..D4 while the enable pin is high
+static void drive_data(hd44780_t *lcd, uint8_t value)
+{
+    for (int d = 0; d < 4; d++)
+    {
+        const gpio_t *gpio = &lcd->gpio->data[d];
+        sim_pin_drive(gpio->port, gpio->pin, (value >> (4 + d)) & 1);
+    }
+}
+
+static uint8_t sample_data(hd44780_t *lcd)
+{
+    uint8_t value = 0;
+
+    // the clcd data pins are wired to D7..D4, D3..D0 are left open
+    for (int d = 0; d < 4; d++)
+        value |= sim_pin_level(lcd->gpio->data[d].port, lcd->gpio->data[d].pin) << (4 + d);
+
+    return value;
+}
+
+static void enable_rise(hd44780_t *lcd, int rs, int rw)
+{
+    uint64_t now = sim_time_us();
+
+    if (lcd->enable_rise_us && (now - lcd->enable_rise_us) * 1000 < HD44780_CYCLE_E_NS)
+        violation(lcd, "enable cycle too short");
+
+    lcd->enable_rise_us = now;
+
+    if (!rw)
+        return;
+
+    // the byte is read at the first nibble, the second nibble has its low bits
+    if (!lcd->four_bit || !lcd->nibble_pending)
+    {
+        int busy = hd44780_busy(lcd);
+
+        if (rs)
+        {
+            if (busy)
+                violation(lcd, "read while busy");
+
+            lcd->read_value = read_data(lcd);
+        }
+        else
+        {
+            lcd->stats.count[HD44780_OP_READ_BUSY]++;
+            lcd->read_value = (busy ? BUSY_FLAG : 0) | (lcd->address & 0x7F);
+        }
+
+        drive_data(lcd, lcd->read_value);
+    }
+    else
+    {
+        drive_data(lcd, lcd->read_value << 4);
+    }
+}
+
+static void enable_fall(hd44780_t *lcd, int rs, int rw)
+{
+    uint64_t now = sim_time_us();
+
+    if ((now - lcd->enable_rise_us) * 1000 < HD44780_PW_EH_NS)
+        violation(lcd, "enable pulse too short");
+
+    lcd->enable_fall_us = now;
+
+    if (lcd->four_bit)
+    {
+        if (!lcd->nibble_pending)
+        {
+            lcd->nibble = sample_data(lcd) & 0xF0;
+            lcd->nibble_pending = 1;
+            return;
+        }
+
+        lcd->nibble_pending = 0;
+    }
+
+    if (rw)
+        return;
+
+    // the controller ignores the instructions while busy
+    if (hd44780_busy(lcd))
+    {
+        violation(lcd, "write while busy");
+        return;
+    }
+
+    uint8_t value = sample_data(lcd);
+    if (lcd->four_bit)
+        value = lcd->nibble | (value >> 4);
+
+    if (rs)
+        write_data(lcd, value);
+    else
+        command(lcd, value);
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+void hd44780_reset(hd44780_t *lcd)
+{
+    const clcd_gpio_t *gpio = lcd->gpio;
+
+    memset(lcd, 0, sizeof(*lcd));
+    memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+    lcd->increment = 1;
+    lcd->lines = 1;
+    lcd->gpio = gpio;
+    lcd->busy_until_us = sim_time_us() + HD44780_POWER_ON_US;
+}
+
+int hd44780_attach(hd44780_t *lcd, const clcd_gpio_t *gpio)
+{
+    if (g_displays_count >= HD44780_MAX_DISPLAYS)
+        return -1;
+
+    lcd->gpio = gpio;
+    g_displays[g_displays_count++] = lcd;
+
+    return 0;
+}
+
+void hd44780_pin(int port, int pin, int level)
+{
+    // the displays share the bus, only the enable pins are their own
+    for (int i = 0; i < g_displays_count; i++)
+    {
+        hd44780_t *lcd = g_displays[i];
+        const clcd_gpio_t *gpio = lcd->gpio;
+
+        if (gpio->en.port != port || gpio->en.pin != pin)
+            continue;
+
+        int rs = sim_pin_level(gpio->rs.port, gpio->rs.pin);
+        int rw = (gpio->rw.pin >= 0 ? sim_pin_level(gpio->rw.port, gpio->rw.pin) : 0);
+
+        if (level)
+            enable_rise(lcd, rs, rw);
+        else
+            enable_fall(lcd, rs, rw);
+    }
+}
+
+void hd44780_line(const hd44780_t *lcd, int line, char *text, int columns)
+{
+    uint8_t address = (line ? HD44780_LINE2 : HD44780_LINE1);
+
+    for (int i = 0; i < columns; i++)
+    {
+        uint8_t c = lcd->ddram[(address + i) & 0x7F];
+        text[i] = (lcd->display_on && c >= 0x20 && c < 0x7F) ? c : ' ';
+    }
+
+    text[columns] = 0;
+}
+
+int hd44780_busy(const hd44780_t *lcd)
+{
+    return sim_time_us() < lcd->busy_until_us;
+}
@@ -0,0 +1,115 @@
+#ifndef HD44780_H
+#define HD44780_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+#include "clcd.h"
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+// DDRAM address of the first column of each line
+#define HD44780_LINE1       0x00
+#define HD44780_LINE2       0x40
+
+// transfers accounted by the model
+enum {
+    HD44780_OP_CLEAR,
+    HD44780_OP_HOME,
+    HD44780_OP_ENTRY_MODE,
+    HD44780_OP_DISPLAY_CONTROL,
+    HD44780_OP_SHIFT,
+    HD44780_OP_FUNCTION_SET,
+    HD44780_OP_CGRAM_ADDRESS,
+    HD44780_OP_DDRAM_ADDRESS,
+    HD44780_OP_WRITE,
+    HD44780_OP_READ_BUSY,
+    HD44780_OP_READ,
+    HD44780_OPS
+};
+
+#define HD44780_OP_NAMES    {"clear", "home", "entry mode", "display control", "shift", \
+                             "function set", "cgram address", "ddram address", "write", \
+                             "read busy", "read"}
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// datasheet timing at fosc = 270 kHz (in microseconds)
+#define HD44780_EXEC_US         37
+#define HD44780_CLEAR_US        1520
+#define HD44780_HOME_US         1520
+// address counter update after a RAM access
+#define HD44780_ADD_US          4
+// wait after the power on and between the function sets of the initialization by instruction
+#define HD44780_POWER_ON_US     40000
+#define HD44780_INIT1_US        4100
+#define HD44780_INIT2_US        100
+
+// enable pulse width and cycle time (in nanoseconds)
+#define HD44780_PW_EH_NS        230
+#define HD44780_CYCLE_E_NS      500
+
+// displays sharing the bus
+#define HD44780_MAX_DISPLAYS    CLCD_MAX_DISPLAYS
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct hd44780_stats_t {
+    uint32_t count[HD44780_OPS];
+    // sum of the execution times of the transfers
+    uint64_t exec_us;
+    // writes latched while busy, short enable pulses and cycles
+    uint32_t violations;
+    const char *violation;
+    uint64_t violation_us;
+} hd44780_stats_t;
+
+typedef struct hd44780_t {
+    uint8_t ddram[128], cgram[64];
+    uint8_t address, increment, display_on, lines;
+    uint8_t four_bit, nibble_pending, nibble, read_value;
+    uint8_t cgram_selected, init_steps;
+    uint32_t changes;
+    uint64_t busy_until_us, enable_rise_us, enable_fall_us;
+    const clcd_gpio_t *gpio;
+    hd44780_stats_t stats;
+} hd44780_t;
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+// the display powers on at the current virtual time and decodes the bus of its pins
+void hd44780_reset(hd44780_t *lcd);
+int hd44780_attach(hd44780_t *lcd, const clcd_gpio_t *gpio);
+
+// to be called on every pin change, latches the bus at the enable edges
+void hd44780_pin(int port, int pin, int level);
+
+void hd44780_line(const hd44780_t *lcd, int line, char *text, int columns);
+int hd44780_busy(const hd44780_t *lcd);
+
+
+#endif
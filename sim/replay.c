@@ -0,0 +1,872 @@
+/*
+ * Replay of input traces in virtual time
+ *
+ * A trace lists what happens on the inputs of the board, one step per line:
+ *
+ *      # comment
+ *      <time> <command> [arguments]
+ *
+ * Times are absolute or relative to the previous step (+), in us (default),
+ * ms or s: 1500000, 1500ms, 1.5s, +350ms. Feet are numbered from 1, the
+ * host commands take the actuator, numbered from 1 with the feet of the
+ * first page followed by the ones of each next page, then the long press,
+ * double tap and repeat gestures of the feet, the expression pedal and last
+ * the edge time of each foot.
+ *
+ *      press F, release F          switch closes, opens
+ *      tap F HOLD                  press and release after HOLD
+ *      pin F LEVEL                 raw level of the switch pin
+ *      bounce F LEVEL COUNT PERIOD COUNT edges PERIOD apart, settles at LEVEL
+ *      assign A MODES [KEY=VALUE]  assignment from the host, MODES joined by +
+ *                                  (toggle trigger options tap_tempo momentary
+ *                                  coloured real integer logarithmic), keys:
+ *                                  label unit value min max def steps list
+ *      unassign A                  assignment removed by the host
+ *      set A VALUE                 value set by the host
+ *      pedal LEVEL [NOISE]         expression pedal at LEVEL (0 to 1023, the
+ *                                  conversions of the ADC), each conversion
+ *                                  off by up to NOISE
+ *      sweep FROM TO DURATION [NOISE] pedal moved from FROM to TO at a steady
+ *                                  rate, the next relative step counts from
+ *                                  the end of the sweep
+ *      end                         stops the replay (1 s after the last step
+ *                                  by default)
+ *
+ * While replaying the control chain library is left out: the host commands
+ * are delivered by the cc task in place of cc_process, and every value
+ * change is answered with an empty frame as the library would send an
+ * update. Each line of the record starts with its virtual time. While the
+ * trace runs it lists the button events read by the application, the LED
+ * pin changes and the actuator values, and the button events and edge times
+ * off the trace by more than SIM_REPLAY_EDGE_TOLERANCE.
+ * At the end the chords line counts the chords, the retracted and deferred
+ * presses and the worst-case delay the chord window added to a press.
+ * The pedal lines count the samples and filter updates of the expression
+ * pedal, then the updates the library got with their lag, the time from the
+ * noiseless pedal reaching the sent position until the library had it.
+ * The button events line gives the largest difference between the time of a
+ * button event (hw_button_time) and the first edge of its bounce sequence.
+ * The edge times line gives the same for the edge the host gets from each
+ * edge time actuator, against the first edge of the last press or release of
+ * its foot (or the press of another foot, for a press a chord takes back).
+ * The task lines give the runs, deadline misses, overruns, worst latency and
+ * worst runtime of each task.
+ * The idle line gives the sleeps and the time the cpu slept, and the wakes
+ * line the worst and mean latency from an interrupt to the first task.
+ * The store lines give the records the store wrote, then the actuators the
+ * next power-up would restore from the EEPROM.
+ * The noise is the same on every run, it only depends on the time.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include "sim.h"
+#include "hardware.h"
+#include "gpio.h"
+#include "control_chain.h"
+#include "chord.h"
+#include "sched.h"
+#include "store.h"
+#include "expression.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+// time the replay runs after the last step when the trace has no end
+#define REPLAY_TAIL         1000000
+
+#define COUNT(x)            (sizeof(x) / sizeof(x[0]))
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+static const gpio_t g_buttons_gpio[] = {BUTTONS_PINS};
+static const gpio_t g_leds_gpio[] = {LEDS_PINS};
+
+static const struct {
+    const char *name;
+    uint32_t mode;
+} g_modes[] = {
+    {"toggle", CC_MODE_TOGGLE},
+    {"trigger", CC_MODE_TRIGGER},
+    {"options", CC_MODE_OPTIONS},
+    {"tap_tempo", CC_MODE_TAP_TEMPO},
+    {"real", CC_MODE_REAL},
+    {"integer", CC_MODE_INTEGER},
+    {"logarithmic", CC_MODE_LOGARITHMIC},
+    {"coloured", CC_MODE_COLOURED},
+    {"momentary", CC_MODE_MOMENTARY},
+};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+enum {STEP_PIN, STEP_ASSIGN, STEP_UNASSIGN, STEP_SET, STEP_PEDAL, STEP_END};
+
+typedef struct step_t {
+    uint64_t time_us;
+    int order;
+    uint8_t type, foot;
+    int level;
+    float value;
+    cc_assignment_t *assignment;
+    // pedal moving from level to value
+    uint32_t duration_us;
+    int noise;
+} step_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static step_t g_steps[SIM_REPLAY_MAX_STEPS];
+static int g_steps_count, g_step;
+
+// host commands waiting for the cc task
+static const step_t *g_commands[SIM_REPLAY_MAX_STEPS];
+static int g_commands_first, g_commands_count;
+
+static cc_assignment_t g_assignments[SIM_REPLAY_MAX_ASSIGNMENTS];
+static option_t g_options[SIM_REPLAY_MAX_OPTIONS];
+static option_t *g_options_list[SIM_REPLAY_MAX_OPTIONS];
+static int g_assignments_count, g_options_count;
+static cc_assignment_t *g_assigned[CC_MAX_ACTUATORS];
+
+static void (*g_response_cb)(void *arg);
+static void (*g_events_cb)(void *arg);
+
+// actuator values as seen by the library
+static float *g_values[CC_MAX_ACTUATORS];
+static float g_values_sent[CC_MAX_ACTUATORS];
+static int g_values_count;
+
+static FILE *g_record;
+static int g_active;
+
+// expression pedal and the lag of its updates
+static const step_t *g_pedal;
+static uint32_t g_pedal_updates, g_pedal_lags;
+static uint64_t g_pedal_lag_sum, g_pedal_lag_max;
+
+// first edge of the bounce sequence of each switch, as the debouncer sees it: a sequence starts at
+// an edge away from the debounced level, and ends with the new level or when the pin is back for
+// the debounce time
+static int g_pin_level[FOOTSWITCHES_COUNT], g_edge_state[FOOTSWITCHES_COUNT];
+static int g_edge_pending[FOOTSWITCHES_COUNT];
+static uint64_t g_edge_us[FOOTSWITCHES_COUNT], g_back_us[FOOTSWITCHES_COUNT];
+static uint32_t g_edges, g_edge_error_max;
+
+// first edge of the last release and press of each switch, on the firmware clock, and how far the
+// edge time actuators put them
+static uint32_t g_event_edge_us[FOOTSWITCHES_COUNT][2];
+static uint32_t g_host_edges, g_host_error_max;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+__attribute__ ((format (printf, 1, 2)))
+static void record(const char *format, ...)
+{
+    va_list ap;
+
+    fprintf(g_record, "%10" PRIu64 " ", sim_time_us());
+    va_start(ap, format);
+    vfprintf(g_record, format, ap);
+    va_end(ap);
+    fputc('\n', g_record);
+}
+
+static void record_close(void)
+{
+    if (g_record && g_record != stdout)
+        fclose(g_record);
+    else if (g_record)
+        fflush(g_record);
+}
+
+// time with an optional unit, relative to the previous step if it starts with +
+static int parse_time(const char *text, uint64_t previous, uint64_t *time_us)
+{
+    int relative = (*text == '+');
+    char *unit;
+
+    double value = strtod(text + relative, &unit);
+    if (unit == text + relative || value < 0)
+        return -1;
+
+    if (!strcmp(unit, "s"))
+        value *= 1000000;
+    else if (!strcmp(unit, "ms"))
+        value *= 1000;
+    else if (*unit && strcmp(unit, "us"))
+        return -1;
+
+    *time_us = (relative ? previous : 0) + (uint64_t) (value + 0.5);
+    return 0;
+}
+
+static void str16_set(str16_t *str, const char *text)
+{
+    snprintf(str->text, sizeof(str->text), "%s", text);
+    str->size = strlen(str->text);
+}
+
+static step_t *step_new(uint64_t time_us, int type, int foot)
+{
+    if (g_steps_count >= SIM_REPLAY_MAX_STEPS)
+        return 0;
+
+    step_t *step = &g_steps[g_steps_count++];
+    memset(step, 0, sizeof(*step));
+    step->time_us = time_us;
+    step->order = g_steps_count;
+    step->type = type;
+    step->foot = foot;
+
+    return step;
+}
+
+static int pin_step(uint64_t time_us, int foot, int level)
+{
+    step_t *step = step_new(time_us, STEP_PIN, foot);
+    if (!step)
+        return -1;
+
+    step->level = level;
+    return 0;
+}
+
+static cc_assignment_t *parse_assignment(int actuator, char *modes, char *save)
+{
+    if (g_assignments_count >= SIM_REPLAY_MAX_ASSIGNMENTS)
+        return 0;
+
+    cc_assignment_t *assignment = &g_assignments[g_assignments_count++];
+    memset(assignment, 0, sizeof(*assignment));
+    assignment->id = g_assignments_count - 1;
+    assignment->actuator_id = actuator;
+    assignment->max = 1.0;
+
+    char label[20];
+    snprintf(label, sizeof(label), "Foot #%d", actuator + 1);
+    str16_set(&assignment->label, label);
+
+    for (char *mode = strtok(modes, "+"); mode; mode = strtok(0, "+"))
+    {
+        unsigned int i;
+        for (i = 0; i < COUNT(g_modes) && strcmp(mode, g_modes[i].name); i++);
+        if (i == COUNT(g_modes))
+            return 0;
+
+        assignment->mode |= g_modes[i].mode;
+    }
+
+    char *arg;
+    while ((arg = strtok_r(0, " \t", &save)))
+    {
+        char *value = strchr(arg, '=');
+        if (!value)
+            return 0;
+
+        *value++ = 0;
+        if (!strcmp(arg, "label"))
+            str16_set(&assignment->label, value);
+        else if (!strcmp(arg, "unit"))
+            str16_set(&assignment->unit, value);
+        else if (!strcmp(arg, "value"))
+            assignment->value = atof(value);
+        else if (!strcmp(arg, "min"))
+            assignment->min = atof(value);
+        else if (!strcmp(arg, "max"))
+            assignment->max = atof(value);
+        else if (!strcmp(arg, "def"))
+            assignment->def = atof(value);
+        else if (!strcmp(arg, "steps"))
+            assignment->steps = atoi(value);
+        else if (!strcmp(arg, "list"))
+        {
+            // options named after their index, the value is the index
+            int count = atoi(value);
+            if (count <= 0 || g_options_count + count > SIM_REPLAY_MAX_OPTIONS)
+                return 0;
+
+            assignment->list_count = count;
+            assignment->list_items = &g_options_list[g_options_count];
+            for (int i = 0; i < count; i++)
+            {
+                option_t *option = &g_options[g_options_count];
+                char name[24];
+                snprintf(name, sizeof(name), "Option %d", i + 1);
+                str16_set(&option->label, name);
+                option->value = i;
+                g_options_list[g_options_count++] = option;
+            }
+        }
+        else
+            return 0;
+    }
+
+    return assignment;
+}
+
+static int pedal_step(uint64_t time_us, int from, int to, uint64_t duration_us, char *noise_arg)
+{
+    step_t *step = step_new(time_us, STEP_PEDAL, 0);
+    if (!step || from < 0 || from > 1023 || to < 0 || to > 1023)
+        return -1;
+
+    step->level = from;
+    step->value = to;
+    step->duration_us = duration_us;
+    step->noise = (noise_arg ? atoi(noise_arg) : 0);
+    return 0;
+}
+
+// conversion without noise, between the levels of the sweep
+static double pedal_level(const step_t *pedal, uint64_t time_us)
+{
+    if (time_us >= pedal->time_us + pedal->duration_us)
+        return pedal->value;
+
+    double done = (time_us < pedal->time_us ? 0 : (double) (time_us - pedal->time_us) / pedal->duration_us);
+    return pedal->level + (pedal->value - pedal->level) * done;
+}
+
+// ADC source of the sim, the noise is a hash of the time
+static int pedal_source(uint64_t time_us)
+{
+    if (!g_pedal)
+        return 0;
+
+    int noise = 0;
+    if (g_pedal->noise > 0)
+    {
+        uint32_t x = (uint32_t) time_us * 2654435761u;
+        x ^= x >> 15;
+        x *= 0x2c1b3c6d;
+        x ^= x >> 12;
+        noise = (int) (x % (2 * g_pedal->noise + 1)) - g_pedal->noise;
+    }
+
+    return (int) (pedal_level(g_pedal, time_us) + 0.5) + noise;
+}
+
+// time since the noiseless pedal reached the position that was sent
+static void pedal_update(float value)
+{
+    g_pedal_updates++;
+    if (!g_pedal)
+        return;
+
+    double level = value * 1023, from = g_pedal->level, to = g_pedal->value;
+    uint64_t reached = g_pedal->time_us + g_pedal->duration_us;
+
+    // the positions the sweep went through, a rest has no lag to measure
+    if (from == to || level < (from < to ? from : to) || level > (from < to ? to : from))
+        return;
+
+    if (g_pedal->duration_us > 0)
+        reached = g_pedal->time_us + (uint64_t) (g_pedal->duration_us * (level - from) / (to - from));
+
+    // the end zones are sent before the pedal gets to the end
+    uint64_t lag = (sim_time_us() > reached ? sim_time_us() - reached : 0);
+    if (lag > g_pedal_lag_max)
+        g_pedal_lag_max = lag;
+
+    g_pedal_lag_sum += lag;
+    g_pedal_lags++;
+}
+
+// edge the host gets from the edge time sent along with a press or a release, as it would take it
+// from the arrival of the frame: it must be the first edge of either, or of the press of another
+// switch for a press a chord takes back
+static void edge_time_update(int foot, float value)
+{
+    uint32_t edge_us = hw_time_us() - (uint32_t) value;
+    uint32_t error_us = UINT32_MAX;
+
+    for (int i = 0; i < FOOTSWITCHES_COUNT * 2; i++)
+    {
+        if (i / 2 != foot && (i % 2) != BUTTON_PRESSED)
+            continue;
+
+        int32_t error = (int32_t) (edge_us - g_event_edge_us[i / 2][i % 2]);
+        if ((uint32_t) (error < 0 ? -error : error) < error_us)
+            error_us = (error < 0 ? -error : error);
+    }
+
+    if (error_us > SIM_REPLAY_EDGE_TOLERANCE)
+        record("foot %d edge time %" PRIu32 "us off the first edge", foot + 1, error_us);
+
+    if (error_us > g_host_error_max)
+        g_host_error_max = error_us;
+
+    g_host_edges++;
+}
+
+static int parse_line(char *line, uint64_t *previous)
+{
+    char *save;
+    char *time = strtok_r(line, " \t", &save);
+    char *command = strtok_r(0, " \t", &save);
+
+    // empty line or comment
+    if (!time || *time == '#')
+        return 0;
+
+    uint64_t time_us;
+    if (!command || parse_time(time, *previous, &time_us) < 0)
+        return -1;
+
+    *previous = time_us;
+
+    if (!strcmp(command, "end"))
+        return (step_new(time_us, STEP_END, 0) ? 0 : -1);
+
+    // the pedal commands take no foot
+    if (!strcmp(command, "pedal"))
+    {
+        char *level_arg = strtok_r(0, " \t", &save);
+        if (!level_arg)
+            return -1;
+
+        int level = atoi(level_arg);
+        return pedal_step(time_us, level, level, 0, strtok_r(0, " \t", &save));
+    }
+
+    if (!strcmp(command, "sweep"))
+    {
+        char *from_arg = strtok_r(0, " \t", &save);
+        char *to_arg = strtok_r(0, " \t", &save);
+        char *duration_arg = strtok_r(0, " \t", &save);
+        uint64_t duration_us;
+
+        if (!from_arg || !to_arg || !duration_arg || parse_time(duration_arg, 0, &duration_us) < 0)
+            return -1;
+
+        *previous = time_us + duration_us;
+        return pedal_step(time_us, atoi(from_arg), atoi(to_arg), duration_us, strtok_r(0, " \t", &save));
+    }
+
+    char *foot_arg = strtok_r(0, " \t", &save);
+    int foot = (foot_arg ? atoi(foot_arg) : 0) - 1;
+    if (foot < 0 || foot >= CC_MAX_ACTUATORS)
+        return -1;
+
+    char *arg = strtok_r(0, " \t", &save);
+
+    // the host commands take an actuator, the other ones a foot
+    int host = (!strcmp(command, "assign") || !strcmp(command, "unassign") || !strcmp(command, "set"));
+    if (!host && foot >= FOOTSWITCHES_COUNT)
+        return -1;
+
+    if (!strcmp(command, "press") || !strcmp(command, "release"))
+        return pin_step(time_us, foot, command[0] == 'r');
+
+    if (!strcmp(command, "pin") && arg)
+        return pin_step(time_us, foot, atoi(arg) ? 1 : 0);
+
+    if (!strcmp(command, "tap") && arg)
+    {
+        uint64_t hold_us;
+        if (parse_time(arg, 0, &hold_us) < 0)
+            return -1;
+
+        return (pin_step(time_us, foot, 0) < 0 ? -1 : pin_step(time_us + hold_us, foot, 1));
+    }
+
+    if (!strcmp(command, "bounce") && arg)
+    {
+        int level = atoi(arg) ? 1 : 0;
+        char *count_arg = strtok_r(0, " \t", &save);
+        char *period_arg = strtok_r(0, " \t", &save);
+        uint64_t period_us;
+
+        if (!count_arg || !period_arg || parse_time(period_arg, 0, &period_us) < 0)
+            return -1;
+
+        // the edges alternate and the last one reaches the final level
+        int count = atoi(count_arg);
+        for (int i = 0; i < count; i++)
+        {
+            if (pin_step(time_us + (i * period_us), foot, ((count - i) & 1) ? level : !level) < 0)
+                return -1;
+        }
+
+        *previous = time_us + ((count > 0 ? count - 1 : 0) * period_us);
+        return 0;
+    }
+
+    if (!strcmp(command, "assign") && arg)
+    {
+        step_t *step = step_new(time_us, STEP_ASSIGN, foot);
+        if (!step || !(step->assignment = parse_assignment(foot, arg, save)))
+            return -1;
+
+        return 0;
+    }
+
+    if (!strcmp(command, "unassign"))
+        return (step_new(time_us, STEP_UNASSIGN, foot) ? 0 : -1);
+
+    if (!strcmp(command, "set") && arg)
+    {
+        step_t *step = step_new(time_us, STEP_SET, foot);
+        if (!step)
+            return -1;
+
+        step->value = atof(arg);
+        return 0;
+    }
+
+    return -1;
+}
+
+static int step_compare(const void *a, const void *b)
+{
+    const step_t *step_a = a, *step_b = b;
+
+    if (step_a->time_us != step_b->time_us)
+        return (step_a->time_us < step_b->time_us ? -1 : 1);
+
+    // same time keeps the trace order
+    return step_a->order - step_b->order;
+}
+
+static void pin_edge(int foot, int level)
+{
+    uint64_t now = sim_time_us();
+    int state = hw_button_state(foot);
+
+    if (level == g_pin_level[foot])
+        return;
+
+    g_pin_level[foot] = level;
+
+    // the pin is low when pressed
+    if (level == !state)
+    {
+        g_back_us[foot] = now;
+    }
+    else if (!g_edge_pending[foot] || g_edge_state[foot] != state ||
+        (now - g_back_us[foot]) >= BUTTON_DEBOUNCE * 1000)
+    {
+        g_edge_pending[foot] = 1;
+        g_edge_state[foot] = state;
+        g_edge_us[foot] = now;
+    }
+}
+
+static void step_run(void *arg)
+{
+    (void) arg;
+
+    while (g_step < g_steps_count && g_steps[g_step].time_us <= sim_time_us())
+    {
+        const step_t *step = &g_steps[g_step++];
+
+        if (step->type == STEP_PIN)
+        {
+            const gpio_t *gpio = &g_buttons_gpio[step->foot];
+            pin_edge(step->foot, step->level);
+            sim_pin_drive(gpio->port, gpio->pin, step->level);
+        }
+        else if (step->type == STEP_PEDAL)
+        {
+            g_pedal = step;
+        }
+        else if (step->type == STEP_END)
+        {
+            // worst-case latency the chord window added to a press
+            const chord_stats_t *chords = chord_stats();
+            record("chords %" PRIu32 " retracted %" PRIu32 " deferred %" PRIu32 " max delay %" PRIu32 "us",
+                chords->chords, chords->retracted, chords->deferred, chords->max_delay_us);
+
+            // the filter updates that didn't reach the library were merged by the coalescer
+            const expression_stats_t *expression = expression_stats();
+            record("pedal samples %" PRIu32 " filter updates %" PRIu32, expression->samples,
+                expression->updates);
+            record("pedal updates %" PRIu32 " lag max %" PRIu64 "us mean %" PRIu64 "us", g_pedal_updates,
+                g_pedal_lag_max, (g_pedal_lags ? g_pedal_lag_sum / g_pedal_lags : 0));
+
+            record("button events %" PRIu32 " first edge error max %" PRIu32 "us", g_edges, g_edge_error_max);
+            record("edge times %" PRIu32 " error max %" PRIu32 "us", g_host_edges, g_host_error_max);
+
+            // the tasks as the diagnostic dump reports them, on the virtual clock
+            sched_stats_t stats;
+            for (int i = 0; sched_stats(i, &stats) == 0; i++)
+            {
+                record("task %s runs %" PRIu32 " deadline misses %" PRIu32 " overruns %" PRIu32 " latency max %"
+                    PRIu32 "us runtime max %" PRIu32 "us", stats.name, stats.runs, stats.deadline_misses,
+                    stats.overruns, stats.latency_max_us, stats.runtime_max_us);
+            }
+
+            // time the cpu slept since the scheduler started, the code takes no virtual time so
+            // the busy time is the one of the blocking delays (lcd, EEPROM) and of the exceptions,
+            // which also make the wake latency: from the first interrupt entry to the first task
+            sched_idle_stats_t idle;
+            sched_idle_stats(&idle);
+            uint64_t idle_permille = (idle.elapsed_us ? (idle.idle_us * 1000) / idle.elapsed_us : 0);
+            record("idle sleeps %" PRIu32 " idle %" PRIu64 ".%" PRIu64 "%% of %" PRIu64 "ms", idle.sleeps,
+                idle_permille / 10, idle_permille % 10, idle.elapsed_us / 1000);
+            record("wakes %" PRIu32 " latency max %" PRIu32 "us mean %" PRIu64 "us", idle.wakes,
+                idle.wake_max_us, (idle.wakes ? idle.wake_total_us / idle.wakes : 0));
+
+            // what the next power-up shows from the last record
+            const store_stats_t *store = store_stats();
+            record("store records %" PRIu32 " pages %" PRIu32 " unchanged %" PRIu32, store->records,
+                store->pages, store->unchanged);
+
+            store_restore();
+            for (int i = 0; i < CC_MAX_ACTUATORS; i++)
+            {
+                if (store_provisional(i))
+                    record("store restores actuator %d", i + 1);
+            }
+
+            exit(0);
+        }
+        else
+        {
+            g_commands[(g_commands_first + g_commands_count++) % SIM_REPLAY_MAX_STEPS] = step;
+        }
+    }
+
+    if (g_step < g_steps_count)
+        sim_at(g_steps[g_step].time_us, step_run, 0);
+}
+
+static void command_run(const step_t *step)
+{
+    cc_event_t event;
+
+    if (step->type == STEP_ASSIGN)
+    {
+        g_assigned[step->foot] = step->assignment;
+        event.id = CC_EV_ASSIGNMENT;
+        event.data = step->assignment;
+        g_events_cb(&event);
+    }
+    else if (step->type == STEP_UNASSIGN)
+    {
+        int actuator_id = step->foot;
+        g_assigned[step->foot] = 0;
+        event.id = CC_EV_UNASSIGNMENT;
+        event.data = &actuator_id;
+        g_events_cb(&event);
+    }
+    else if (step->type == STEP_SET && g_assigned[step->foot])
+    {
+        cc_set_value_t set_value;
+        set_value.assignment_id = g_assigned[step->foot]->id;
+        set_value.actuator_id = step->foot;
+        set_value.value = step->value;
+        event.id = CC_CMD_SET_VALUE;
+        event.data = &set_value;
+        g_events_cb(&event);
+    }
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+int sim_replay_load(const char *trace, const char *record_file)
+{
+    FILE *fp = fopen(trace, "r");
+    if (!fp)
+    {
+        perror(trace);
+        return -1;
+    }
+
+    char line[256];
+    int line_number = 0;
+    uint64_t previous = 0;
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        line_number++;
+        line[strcspn(line, "\r\n")] = 0;
+
+        if (parse_line(line, &previous) < 0)
+        {
+            fprintf(stderr, "%s:%d: invalid step\n", trace, line_number);
+            fclose(fp);
+            return -1;
+        }
+    }
+
+    fclose(fp);
+
+    qsort(g_steps, g_steps_count, sizeof(step_t), step_compare);
+
+    if (g_steps_count == 0 || g_steps[g_steps_count - 1].type != STEP_END)
+    {
+        uint64_t last = (g_steps_count ? g_steps[g_steps_count - 1].time_us : 0);
+        step_new(last + REPLAY_TAIL, STEP_END, 0);
+    }
+
+    g_record = (record_file ? fopen(record_file, "w") : stdout);
+    if (!g_record)
+    {
+        perror(record_file);
+        return -1;
+    }
+
+    // the switches are open, the pins pulled up
+    for (int i = 0; i < FOOTSWITCHES_COUNT; i++)
+        g_pin_level[i] = 1;
+
+    atexit(record_close);
+    sim_adc_source(pedal_source);
+    g_active = 1;
+    sim_at(g_steps[0].time_us, step_run, 0);
+
+    return 0;
+}
+
+int sim_replay_active(void)
+{
+    return g_active;
+}
+
+void sim_replay_pin(int port, int pin, int level)
+{
+    static const char colours[] = "RGB";
+
+    for (unsigned int i = 0; i < COUNT(g_leds_gpio); i++)
+    {
+        // LEDs are active low
+        if (g_leds_gpio[i].port == port && g_leds_gpio[i].pin == pin)
+            record("led %u %c %s", (i / 3) + 1, colours[i % 3], level ? "off" : "on");
+    }
+}
+
+// the build wraps these functions (see SIM_LDFLAGS)
+void __real_cc_init(void (*response_cb)(void *arg), void (*events_cb)(void *arg));
+void __real_cc_process(void);
+cc_actuator_t *__real_cc_actuator_new(cc_actuator_config_t *config);
+int __real_hw_button(int button);
+
+void __wrap_cc_init(void (*response_cb)(void *arg), void (*events_cb)(void *arg))
+{
+    g_response_cb = response_cb;
+    g_events_cb = events_cb;
+    __real_cc_init(response_cb, events_cb);
+}
+
+cc_actuator_t *__wrap_cc_actuator_new(cc_actuator_config_t *config)
+{
+    if (g_values_count < CC_MAX_ACTUATORS)
+    {
+        g_values_sent[g_values_count] = *config->value;
+        g_values[g_values_count++] = config->value;
+    }
+
+    return __real_cc_actuator_new(config);
+}
+
+void __wrap_cc_process(void)
+{
+    if (!g_active)
+    {
+        __real_cc_process();
+        return;
+    }
+
+    while (g_commands_count > 0)
+    {
+        const step_t *step = g_commands[g_commands_first];
+        g_commands_first = (g_commands_first + 1) % SIM_REPLAY_MAX_STEPS;
+        g_commands_count--;
+        command_run(step);
+    }
+
+    int changed = 0;
+    for (int i = 0; i < g_values_count; i++)
+    {
+        if (*g_values[i] == g_values_sent[i])
+            continue;
+
+        g_values_sent[i] = *g_values[i];
+        record("value %d %g", i + 1, g_values_sent[i]);
+        changed = 1;
+
+        if (i == EXPRESSION_ACTUATOR)
+            pedal_update(g_values_sent[i]);
+
+        if (i >= EDGE_TIME_ACTUATOR(0))
+            edge_time_update(i - EDGE_TIME_ACTUATOR(0), g_values_sent[i]);
+
+        // the library keeps the tap tempo of the assignment in step with the actuator
+        cc_assignment_t *assignment = g_assigned[i];
+        if (assignment && (assignment->mode & CC_MODE_TAP_TEMPO))
+            assignment->value = g_values_sent[i];
+    }
+
+    if (changed && g_response_cb)
+    {
+        cc_data_t frame = {0, 0};
+        g_response_cb(&frame);
+    }
+}
+
+int __wrap_hw_button(int button)
+{
+    int event = __real_hw_button(button);
+
+    // time from the first edge of the switch until the application read the event
+    if (g_active && event >= 0)
+    {
+        record("button %d %s +%" PRIu32 "us", button + 1,
+            event == BUTTON_PRESSED ? "pressed" : "released", hw_time_us() - hw_button_time(button));
+
+        // the event time is the one of the first edge of the sequence (the firmware counts its
+        // time from the start of the systick)
+        uint32_t edge_us = g_edge_us[button] - (sim_time_us() - hw_time_us());
+        int32_t error = (int32_t) (hw_button_time(button) - edge_us);
+        uint32_t error_us = (error < 0 ? -error : error);
+        if (error_us > SIM_REPLAY_EDGE_TOLERANCE)
+            record("button %d event %+" PRId32 "us from the first edge", button + 1, error);
+
+        if (error_us > g_edge_error_max)
+            g_edge_error_max = error_us;
+
+        g_edges++;
+        g_event_edge_us[button][event == BUTTON_PRESSED] = edge_us;
+    }
+
+    return event;
+}
@@ -0,0 +1,212 @@
+/*
+ * UART exposed as a pseudo terminal
+ *
+ * The CC master connects to the pty slave printed at start-up (or to the
+ * link given with --link). The baud rate only sets the time a frame takes
+ * on the wire, which moves the latency measurement.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "serial.h"
+#include "sim.h"
+#include "trace.h"
+#include "latency.h"
+#include "sched.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+// start bit, 8 data bits and stop bit
+#define BITS_PER_CHAR       10
+// bytes delivered to the receive callback at once, as the uart fifo
+#define RX_CHUNK_SIZE       16
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+struct serial_t {
+    int master, slave;
+    char port[64];
+    uint32_t char_time_us;
+    uint64_t wire_free_us;
+    // time the last bytes read from the pty are over on the wire
+    uint64_t rx_end_us;
+    void (*receive_cb)(void *arg);
+    serial_stats_t stats;
+};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static serial_t g_serial = {.master = -1, .slave = -1};
+static const char *g_link;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void wire_done(void *arg)
+{
+    (void) arg;
+    latency_frame(LAT_WIRE);
+}
+
+static void receive(int fd)
+{
+    // stands in for the interrupt of the uart
+    sched_irq_entry();
+
+    uint8_t buffer[256];
+    ssize_t read_size = read(fd, buffer, sizeof(buffer));
+
+    // the pty gives the bytes at once, they came at the rate of the wire
+    if (read_size > 0)
+        g_serial.rx_end_us = sim_time_us() + (read_size * g_serial.char_time_us);
+
+    for (ssize_t offset = 0; offset < read_size; offset += RX_CHUNK_SIZE)
+    {
+        serial_data_t sdata;
+        sdata.data = &buffer[offset];
+        sdata.size = (read_size - offset > RX_CHUNK_SIZE ? RX_CHUNK_SIZE : read_size - offset);
+
+        trace_record(TRACE_RX, sdata.data, sdata.size);
+
+        if (g_serial.receive_cb)
+            g_serial.receive_cb(&sdata);
+    }
+}
+
+static void unlink_port(void)
+{
+    if (g_link)
+        unlink(g_link);
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+serial_t *serial_init(uint32_t baud_rate, void (*receive_cb)(void *arg))
+{
+    serial_t *serial = &g_serial;
+
+    serial->master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (serial->master < 0 || grantpt(serial->master) < 0 || unlockpt(serial->master) < 0)
+    {
+        perror("sim: pty");
+        exit(1);
+    }
+
+    snprintf(serial->port, sizeof(serial->port), "%s", ptsname(serial->master));
+
+    // the slave stays open so the master doesn't see a hang up while no one is connected
+    serial->slave = open(serial->port, O_RDWR | O_NOCTTY);
+    struct termios tio;
+    tcgetattr(serial->slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(serial->slave, TCSANOW, &tio);
+
+    fcntl(serial->master, F_SETFL, fcntl(serial->master, F_GETFL) | O_NONBLOCK);
+
+    if (g_link)
+    {
+        unlink(g_link);
+        if (symlink(serial->port, g_link) == 0)
+            atexit(unlink_port);
+        else
+            perror("sim: link");
+    }
+
+    fprintf(stderr, "sim: uart at %s%s%s\n", serial->port, g_link ? " linked as " : "", g_link ? g_link : "");
+
+    serial->receive_cb = receive_cb;
+    serial_baud_rate_set(baud_rate);
+    sim_fd_add(serial->master, receive);
+
+    return serial;
+}
+
+void serial_send(serial_t *serial, serial_data_t *sdata)
+{
+    latency_frame(LAT_ENQUEUE);
+
+    ssize_t written = write(serial->master, sdata->data, sdata->size);
+    if (written > 0)
+        trace_record(TRACE_TX, sdata->data, written);
+
+    // a frame the pty didn't take whole is lost for the master
+    if (written == (ssize_t) sdata->size)
+        serial->stats.frames++;
+    else
+        serial->stats.dropped++;
+
+    // frames leave back to back
+    uint64_t now = sim_time_us();
+    if (serial->wire_free_us < now)
+        serial->wire_free_us = now;
+
+    serial->wire_free_us += sdata->size * serial->char_time_us;
+    sim_at(serial->wire_free_us, wire_done, 0);
+}
+
+// the pty takes the whole frame at once
+uint32_t serial_tx_pending(serial_t *serial)
+{
+    (void) serial;
+    return 0;
+}
+
+int serial_receiving(serial_t *serial)
+{
+    return sim_time_us() < serial->rx_end_us + (SERIAL_RX_GAP_CHARS * serial->char_time_us);
+}
+
+uint32_t serial_baud_rate_set(uint32_t baud_rate)
+{
+    g_serial.char_time_us = ((BITS_PER_CHAR * 1000000) + baud_rate - 1) / baud_rate;
+    return baud_rate;
+}
+
+const serial_stats_t *serial_stats(void)
+{
+    return &g_serial.stats;
+}
+
+const char *sim_serial_port(void)
+{
+    return g_serial.port;
+}
+
+void sim_serial_link(const char *path)
+{
+    g_link = path;
+}
@@ -0,0 +1,502 @@
+/*
+ * Host simulation of the footswitch
+ *
+ * The firmware runs unchanged on top of the virtual chip (chip.c). This file
+ * wires the board: switches driven from the keyboard, LEDs and the two
+ * HD44780 displays drawn on the terminal, and the polling of the inputs
+ * while the firmware sleeps.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include "sim.h"
+#include "hd44780.h"
+#include "hardware.h"
+#include "clcd.h"
+
+// the firmware entry point is renamed by the build
+#undef main
+int firmware_main(void);
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define LCD_COLUMNS         16
+#define LCD_COUNT           2
+
+// time a switch is held by a tap (in microseconds)
+#define TAP_TIME            150000
+// terminal refresh period (in microseconds)
+#define UI_PERIOD           20000
+
+#define COUNT(x)            (sizeof(x) / sizeof(x[0]))
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+static const gpio_t g_buttons_gpio[] = {BUTTONS_PINS};
+static const gpio_t g_leds_gpio[] = {LEDS_PINS};
+static const clcd_gpio_t g_lcds_gpio[LCD_COUNT] = {LCD1_PINS, LCD2_PINS};
+
+static const char g_tap_keys[] = "1234";
+static const char g_hold_keys[] = "qwer";
+
+static const char *g_usage =
+    "usage: %s [options]\n"
+    "  --speed X        virtual time runs X times the wall clock, 0 runs as fast as possible\n"
+    "  --eeprom FILE    EEPROM contents, loaded at start and saved at exit\n"
+    "  --link PATH      symbolic link to the uart pseudo terminal\n"
+    "  --duration S     exits after S seconds of virtual time\n"
+    "  --headless       prints the display changes instead of drawing the board\n"
+    "  --replay TRACE   replays the input trace as fast as possible (see sim/replay.c)\n"
+    "  --record FILE    record of the replay, stdout by default\n"
+    "keys: 1-4 tap a switch, q w e r hold/release a switch, x exits\n";
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct poll_fd_t {
+    int fd;
+    void (*callback)(int fd);
+} poll_fd_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static hd44780_t g_lcds[LCD_COUNT];
+static char g_lcds_text[LCD_COUNT][2][LCD_COLUMNS + 1];
+static int g_buttons_level[COUNT(g_buttons_gpio)];
+static int g_leds_changed;
+
+static poll_fd_t g_fds[SIM_MAX_FDS];
+static int g_fds_count;
+
+static const char *g_eeprom_file;
+static int g_headless;
+static struct termios g_termios;
+static int g_termios_saved;
+static volatile sig_atomic_t g_quit;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void button_drive(int button, int pressed)
+{
+    const gpio_t *gpio = &g_buttons_gpio[button];
+
+    // the switches pull the pins to ground
+    g_buttons_level[button] = !pressed;
+    sim_pin_drive(gpio->port, gpio->pin, g_buttons_level[button]);
+}
+
+static void button_release(void *arg)
+{
+    button_drive((int) (intptr_t) arg, 0);
+}
+
+static void pin_changed(int port, int pin, int level)
+{
+    if (sim_replay_active())
+        sim_replay_pin(port, pin, level);
+
+    for (unsigned int i = 0; i < COUNT(g_leds_gpio); i++)
+    {
+        if (g_leds_gpio[i].port == port && g_leds_gpio[i].pin == pin)
+        {
+            g_leds_changed = 1;
+            return;
+        }
+    }
+
+    hd44780_pin(port, pin, level);
+}
+
+// ANSI colour of the foot LED, 0 if it is off
+static int led_colour(int foot)
+{
+    int colour = 0;
+
+    // LEDs are active low
+    for (int c = 0; c < 3; c++)
+    {
+        const gpio_t *gpio = &g_leds_gpio[(foot * 3) + c];
+        if (!sim_pin_level(gpio->port, gpio->pin))
+            colour |= 1 << c;
+    }
+
+    return colour;
+}
+
+static int lcds_update(void)
+{
+    int changed = 0;
+
+    for (int i = 0; i < LCD_COUNT; i++)
+    {
+        for (int line = 0; line < 2; line++)
+        {
+            char text[LCD_COLUMNS + 1];
+            hd44780_line(&g_lcds[i], line, text, LCD_COLUMNS);
+
+            if (strcmp(text, g_lcds_text[i][line]))
+            {
+                strcpy(g_lcds_text[i][line], text);
+                changed = 1;
+            }
+        }
+    }
+
+    return changed;
+}
+
+static void print_headless(void)
+{
+    static const char colours[] = ".RGYBMCW";
+    double time = sim_time_us() / 1000000.0;
+
+    printf("[%10.3f]", time);
+    for (int i = 0; i < LCD_COUNT; i++)
+        printf(" |%s|%s|", g_lcds_text[i][0], g_lcds_text[i][1]);
+
+    printf(" ");
+    for (unsigned int foot = 0; foot < COUNT(g_buttons_gpio); foot++)
+        putchar(colours[led_colour(foot)]);
+
+    printf("\n");
+    fflush(stdout);
+}
+
+static void draw_board(void)
+{
+    printf("\033[H\033[2J");
+    printf("footswitch simulator - uart at %s\r\n\r\n", sim_serial_port());
+
+    for (int i = 0; i < LCD_COUNT; i++)
+        printf("+%.*s+  ", LCD_COLUMNS, "--------------------------------");
+    printf("\r\n");
+
+    for (int line = 0; line < 2; line++)
+    {
+        for (int i = 0; i < LCD_COUNT; i++)
+            printf("|%s|  ", g_lcds_text[i][line]);
+        printf("\r\n");
+    }
+
+    for (int i = 0; i < LCD_COUNT; i++)
+        printf("+%.*s+  ", LCD_COLUMNS, "--------------------------------");
+    printf("\r\n\r\n");
+
+    for (unsigned int foot = 0; foot < COUNT(g_buttons_gpio); foot++)
+    {
+        int colour = led_colour(foot);
+        if (colour)
+            printf("  \033[1;%dm(*)\033[0m", 30 + colour);
+        else
+            printf("  ( )");
+
+        printf(" %c%c  ", g_tap_keys[foot], g_buttons_level[foot] ? ' ' : '#');
+    }
+
+    printf("\r\n\r\ntime %.1f s\r\n", sim_time_us() / 1000000.0);
+    fflush(stdout);
+}
+
+static void ui_refresh(void *arg)
+{
+    (void) arg;
+
+    static uint64_t drawn_second;
+    uint64_t second = sim_time_us() / 1000000;
+
+    int changed = lcds_update() || g_leds_changed;
+    g_leds_changed = 0;
+
+    if (g_headless)
+    {
+        if (changed)
+            print_headless();
+    }
+    else if (changed || second != drawn_second)
+    {
+        drawn_second = second;
+        draw_board();
+    }
+
+    sim_at(sim_time_us() + UI_PERIOD, ui_refresh, 0);
+}
+
+static void key_input(int fd)
+{
+    char keys[16];
+    ssize_t size = read(fd, keys, sizeof(keys));
+
+    if (size <= 0)
+    {
+        // end of input
+        if (size == 0)
+            sim_fd_add(fd, 0);
+        return;
+    }
+
+    for (ssize_t i = 0; i < size; i++)
+    {
+        const char *tap = strchr(g_tap_keys, keys[i]);
+        const char *hold = strchr(g_hold_keys, keys[i]);
+
+        if (keys[i] == 'x')
+        {
+            g_quit = 1;
+        }
+        else if (tap && keys[i])
+        {
+            int button = tap - g_tap_keys;
+            button_drive(button, 1);
+            sim_at(sim_time_us() + TAP_TIME, button_release, (void *) (intptr_t) button);
+        }
+        else if (hold && keys[i])
+        {
+            int button = hold - g_hold_keys;
+            // a released switch reads high, so its level is the new pressed state
+            button_drive(button, g_buttons_level[button]);
+        }
+    }
+}
+
+static void quit(void *arg)
+{
+    (void) arg;
+    g_quit = 1;
+}
+
+static void signal_handler(int signum)
+{
+    (void) signum;
+    g_quit = 1;
+}
+
+static void cleanup(void)
+{
+    if (g_termios_saved)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &g_termios);
+        printf("\r\n");
+    }
+
+    if (g_eeprom_file && sim_eeprom_save(g_eeprom_file) < 0)
+        perror("sim: eeprom");
+
+    for (int i = 0; i < LCD_COUNT; i++)
+    {
+        const hd44780_stats_t *stats = &g_lcds[i].stats;
+        if (stats->violations)
+        {
+            fprintf(stderr, "sim: lcd %d: %u timing violations, the last one %s at %llu us\n", i + 1,
+                stats->violations, stats->violation, (unsigned long long) stats->violation_us);
+        }
+    }
+}
+
+static void terminal_setup(void)
+{
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &g_termios) < 0)
+        return;
+
+    g_termios_saved = 1;
+
+    // keys are read one at a time, ctrl-c still stops the simulation
+    struct termios tio = g_termios;
+    tio.c_lflag &= ~(ICANON | ECHO);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &tio);
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+void sim_fd_add(int fd, void (*callback)(int fd))
+{
+    for (int i = 0; i < g_fds_count; i++)
+    {
+        if (g_fds[i].fd == fd)
+        {
+            // no callback removes the file descriptor
+            if (!callback)
+                g_fds[i] = g_fds[--g_fds_count];
+            else
+                g_fds[i].callback = callback;
+
+            return;
+        }
+    }
+
+    if (callback && g_fds_count < SIM_MAX_FDS)
+    {
+        g_fds[g_fds_count].fd = fd;
+        g_fds[g_fds_count].callback = callback;
+        g_fds_count++;
+    }
+}
+
+int sim_poll(int64_t timeout_us)
+{
+    if (g_quit)
+        exit(0);
+
+    fd_set fds;
+    int max_fd = -1;
+
+    FD_ZERO(&fds);
+    for (int i = 0; i < g_fds_count; i++)
+    {
+        FD_SET(g_fds[i].fd, &fds);
+        if (g_fds[i].fd > max_fd)
+            max_fd = g_fds[i].fd;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = timeout_us / 1000000;
+    tv.tv_usec = timeout_us % 1000000;
+
+    if (select(max_fd + 1, &fds, 0, 0, &tv) <= 0)
+        return 0;
+
+    // the inputs happen at the current wall clock
+    sim_clock_sync();
+
+    int handled = 0;
+    poll_fd_t ready[SIM_MAX_FDS];
+    int ready_count = 0;
+
+    for (int i = 0; i < g_fds_count; i++)
+    {
+        if (FD_ISSET(g_fds[i].fd, &fds))
+            ready[ready_count++] = g_fds[i];
+    }
+
+    for (int i = 0; i < ready_count; i++)
+    {
+        ready[i].callback(ready[i].fd);
+        handled++;
+    }
+
+    return handled;
+}
+
+int main(int argc, char *argv[])
+{
+    double speed = 1.0, duration = 0.0;
+    const char *replay = 0, *record = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc ? argv[i + 1] : 0);
+
+        if (!strcmp(arg, "--headless"))
+        {
+            g_headless = 1;
+            continue;
+        }
+
+        if (value && !strcmp(arg, "--speed"))
+            speed = atof(value);
+        else if (value && !strcmp(arg, "--eeprom"))
+            g_eeprom_file = value;
+        else if (value && !strcmp(arg, "--link"))
+            sim_serial_link(value);
+        else if (value && !strcmp(arg, "--duration"))
+            duration = atof(value);
+        else if (value && !strcmp(arg, "--replay"))
+            replay = value;
+        else if (value && !strcmp(arg, "--record"))
+            record = value;
+        else
+        {
+            fprintf(stderr, g_usage, argv[0]);
+            return (strcmp(arg, "--help") ? 1 : 0);
+        }
+
+        i++;
+    }
+
+    if (sim_eeprom_load(g_eeprom_file) < 0)
+        fprintf(stderr, "sim: %s not found, starting with an erased EEPROM\n", g_eeprom_file);
+
+    // a replay only depends on the trace
+    if (replay)
+    {
+        if (sim_replay_load(replay, record) < 0)
+            return 1;
+
+        speed = 0.0;
+    }
+
+    sim_clock_pacing(speed);
+
+    // board
+    for (int i = 0; i < LCD_COUNT; i++)
+    {
+        hd44780_reset(&g_lcds[i]);
+        hd44780_attach(&g_lcds[i], &g_lcds_gpio[i]);
+    }
+
+    for (unsigned int i = 0; i < COUNT(g_buttons_gpio); i++)
+        button_drive(i, 0);
+
+    sim_pin_watch(pin_changed);
+
+    atexit(cleanup);
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    // user interface
+    if (!replay)
+    {
+        if (!g_headless)
+            terminal_setup();
+
+        sim_fd_add(STDIN_FILENO, key_input);
+        sim_at(UI_PERIOD, ui_refresh, 0);
+    }
+
+    if (duration > 0)
+        sim_at((uint64_t) (duration * 1000000), quit, 0);
+
+    return firmware_main();
+}
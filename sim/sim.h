@@ -0,0 +1,92 @@
+#ifndef SIM_H
+#define SIM_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// maximum number of pending events of the virtual clock
+#define SIM_MAX_EVENTS      32
+// maximum number of file descriptors polled while the firmware sleeps
+#define SIM_MAX_FDS         4
+// maximum number of steps, assignments and options of a replayed trace
+#define SIM_REPLAY_MAX_STEPS        1024
+#define SIM_REPLAY_MAX_ASSIGNMENTS  16
+#define SIM_REPLAY_MAX_OPTIONS      64
+// largest difference between the time of a button event and the first edge of its bounce sequence
+// in the trace (in us), a bigger one is recorded
+#define SIM_REPLAY_EDGE_TOLERANCE   100
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef void (*sim_event_cb_t)(void *arg);
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+// virtual clock (chip.c)
+uint64_t sim_time_us(void);
+void sim_advance(uint32_t us);
+int sim_at(uint64_t time_us, sim_event_cb_t callback, void *arg);
+void sim_clock_pacing(double speed);
+void sim_clock_sync(void);
+
+// virtual pins (chip.c), a pin driven by the board reads as the given level when it's an input
+void sim_pin_drive(int port, int pin, int level);
+int sim_pin_level(int port, int pin);
+void sim_pin_watch(void (*callback)(int port, int pin, int level));
+
+// EEPROM contents (chip.c), erased if there is no file
+int sim_eeprom_load(const char *filename);
+int sim_eeprom_save(const char *filename);
+
+// interrupt of a peripheral model (chip.c), the handler runs now or when the interrupt is enabled
+void sim_irq(int irq, void (*handler)(void));
+
+// characters of the virtual uart on the wire (uart.c), in nanoseconds
+void sim_uart_watch(void (*callback)(uint8_t byte, uint64_t start_ns, uint64_t end_ns));
+
+// file descriptors polled while the firmware sleeps (sim.c)
+void sim_fd_add(int fd, void (*callback)(int fd));
+int sim_poll(int64_t timeout_us);
+
+// replay of input traces (replay.c), the record goes to stdout if there is no file
+int sim_replay_load(const char *trace, const char *record_file);
+int sim_replay_active(void);
+void sim_replay_pin(int port, int pin, int level);
+
+// analog input (adc.c), the source gives the conversion read at a time (0 to 1023)
+void sim_adc_source(int (*source)(uint64_t time_us));
+
+// uart (serial.c)
+const char *sim_serial_port(void);
+void sim_serial_link(const char *path);
+
+#endif
@@ -0,0 +1,336 @@
+/*
+ * Virtual UART and 32-bit timer 0
+ *
+ * The transmit side of the uart (16-byte fifo, shift register and THRE
+ * interrupt) and the match of the timer that times the RS-485 driver enable
+ * in src/serial.c. The simulation replaces that driver with a pty
+ * (sim/serial.c), these models run the real one in the driver enable bench
+ * (bench/serial.c), the only program that links them. The characters are
+ * timed in nanoseconds from the divisor latch and the fractional divider,
+ * the events of the virtual clock fall on the next microsecond.
+ */
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "chip.h"
+#include "sim.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define TX_FIFO_SIZE        16
+// uart clock cycles per bit
+#define OVERSAMPLING        16
+// start bit, 8 data bits and stop bit
+#define BITS_PER_CHAR       10
+
+#define MATCH_COUNT         4
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct uart_t {
+    uint8_t fifo[TX_FIFO_SIZE];
+    int count;
+    uint32_t ier;
+    uint16_t dl;
+    // character in the shift register
+    int shifting;
+    uint8_t shift_byte;
+    uint64_t shift_start_ns, shift_end_ns;
+} uart_t;
+
+typedef struct timer_t {
+    uint32_t match[MATCH_COUNT];
+    uint8_t int_enabled, pending;
+    // a disabled timer drops the match event scheduled when it was enabled
+    uint32_t generation;
+} sim_timer_t;
+
+
+/*
+****************************************************************************************************
+*       GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+LPC_USART_T sim_usart = {.FDR = 0x10};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static uart_t g_uart = {.dl = 1};
+static sim_timer_t g_timer;
+static void (*g_uart_watch)(uint8_t byte, uint64_t start_ns, uint64_t end_ns);
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+void UART_IRQHandler(void);
+void TIMER32_0_IRQHandler(void);
+
+// baud = clock / (16 * dl * (1 + divaddval / mulval))
+static uint64_t char_time_ns(void)
+{
+    uint64_t mulval = (sim_usart.FDR >> 4) & 0xF, divaddval = sim_usart.FDR & 0xF;
+    if (mulval == 0)
+        mulval = 1;
+
+    uint64_t num = (uint64_t) BITS_PER_CHAR * 1000000000 * OVERSAMPLING * g_uart.dl * (mulval + divaddval);
+    uint64_t den = (uint64_t) SystemCoreClock * mulval;
+    return (num + (den / 2)) / den;
+}
+
+static uint64_t now_ns(void)
+{
+    return sim_time_us() * 1000;
+}
+
+// the THRE interrupt is raised when the fifo runs empty, if it is still empty when delivered
+static void thre_raise(void *arg)
+{
+    (void) arg;
+
+    if (g_uart.count == 0 && (g_uart.ier & UART_IER_THREINT))
+        sim_irq(UART0_IRQn, UART_IRQHandler);
+}
+
+static void shift_done(void *arg);
+
+// the shift register takes the next character of the fifo
+static void shift_next(uint64_t start_ns)
+{
+    if (g_uart.count == 0)
+        return;
+
+    g_uart.shift_byte = g_uart.fifo[0];
+    g_uart.count--;
+    for (int i = 0; i < g_uart.count; i++)
+        g_uart.fifo[i] = g_uart.fifo[i + 1];
+
+    g_uart.shifting = 1;
+    g_uart.shift_start_ns = start_ns;
+    g_uart.shift_end_ns = start_ns + char_time_ns();
+    sim_at((g_uart.shift_end_ns + 999) / 1000, shift_done, 0);
+
+    // the interrupt is taken after the code that wrote the fifo
+    if (g_uart.count == 0)
+        sim_at(sim_time_us(), thre_raise, 0);
+}
+
+static void shift_done(void *arg)
+{
+    (void) arg;
+
+    g_uart.shifting = 0;
+    if (g_uart_watch)
+        g_uart_watch(g_uart.shift_byte, g_uart.shift_start_ns, g_uart.shift_end_ns);
+
+    // the next character follows the stop bit
+    shift_next(g_uart.shift_end_ns);
+}
+
+static void timer_match(void *arg)
+{
+    if ((uint32_t) (uintptr_t) arg != g_timer.generation)
+        return;
+
+    g_timer.pending = 1;
+    if ((g_timer.int_enabled & (1 << 1)))
+        sim_irq(TIMER_32_0_IRQn, TIMER32_0_IRQHandler);
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+void sim_uart_watch(void (*callback)(uint8_t byte, uint64_t start_ns, uint64_t end_ns))
+{
+    g_uart_watch = callback;
+}
+
+void Chip_UART_Init(LPC_USART_T *pUART)
+{
+    (void) pUART;
+    g_uart.count = 0;
+    g_uart.ier = 0;
+}
+
+void Chip_UART_ConfigData(LPC_USART_T *pUART, uint32_t config)
+{
+    (void) pUART;
+    (void) config;
+}
+
+void Chip_UART_SetupFIFOS(LPC_USART_T *pUART, uint32_t fcr)
+{
+    (void) pUART;
+    (void) fcr;
+}
+
+void Chip_UART_TXEnable(LPC_USART_T *pUART)
+{
+    (void) pUART;
+}
+
+void Chip_UART_IntEnable(LPC_USART_T *pUART, uint32_t intMask)
+{
+    (void) pUART;
+
+    // enabling the interrupt with an empty fifo raises it
+    if ((intMask & UART_IER_THREINT) && !(g_uart.ier & UART_IER_THREINT) && g_uart.count == 0)
+        sim_at(sim_time_us(), thre_raise, 0);
+
+    g_uart.ier |= intMask;
+}
+
+void Chip_UART_IntDisable(LPC_USART_T *pUART, uint32_t intMask)
+{
+    (void) pUART;
+    g_uart.ier &= ~intMask;
+}
+
+void Chip_UART_EnableDivisorAccess(LPC_USART_T *pUART)
+{
+    (void) pUART;
+}
+
+void Chip_UART_DisableDivisorAccess(LPC_USART_T *pUART)
+{
+    (void) pUART;
+}
+
+void Chip_UART_SetDivisorLatches(LPC_USART_T *pUART, uint8_t dll, uint8_t dlm)
+{
+    (void) pUART;
+    g_uart.dl = dll | (dlm << 8);
+}
+
+// nothing is received, the bench only drives the transmitter
+uint32_t Chip_UART_ReadLineStatus(LPC_USART_T *pUART)
+{
+    (void) pUART;
+
+    uint32_t status = 0;
+    if (g_uart.count == 0)
+        status |= UART_LSR_THRE;
+    if (g_uart.count == 0 && !g_uart.shifting)
+        status |= UART_LSR_TEMT;
+
+    return status;
+}
+
+void Chip_UART_SendByte(LPC_USART_T *pUART, uint8_t data)
+{
+    (void) pUART;
+
+    // a write to a full fifo is lost
+    if (g_uart.count == TX_FIFO_SIZE)
+        return;
+
+    g_uart.fifo[g_uart.count++] = data;
+
+    if (!g_uart.shifting)
+        shift_next(now_ns());
+}
+
+// as the LPCOpen handler: one character per call, THRE is cleared by the write
+void Chip_UART_TXIntHandlerRB(LPC_USART_T *pUART, RINGBUFF_T *pRB)
+{
+    uint8_t ch;
+
+    while ((Chip_UART_ReadLineStatus(pUART) & UART_LSR_THRE) != 0 && RingBuffer_Pop(pRB, &ch))
+        Chip_UART_SendByte(pUART, ch);
+}
+
+void Chip_UART_RXIntHandlerRB(LPC_USART_T *pUART, RINGBUFF_T *pRB)
+{
+    (void) pUART;
+    (void) pRB;
+}
+
+int Chip_UART_ReadRB(LPC_USART_T *pUART, RINGBUFF_T *pRB, void *data, int bytes)
+{
+    (void) pUART;
+    return RingBuffer_PopMult(pRB, data, bytes);
+}
+
+void Chip_TIMER_Init(LPC_TIMER_T *pTMR)
+{
+    (void) pTMR;
+}
+
+void Chip_TIMER_Reset(LPC_TIMER_T *pTMR)
+{
+    (void) pTMR;
+}
+
+// the timer counts the system clock from zero, the match fires on the next microsecond
+void Chip_TIMER_Enable(LPC_TIMER_T *pTMR)
+{
+    (void) pTMR;
+
+    uint32_t ticks_per_us = SystemCoreClock / 1000000;
+    uint64_t time_us = sim_time_us() + ((g_timer.match[1] + ticks_per_us - 1) / ticks_per_us);
+    sim_at(time_us, timer_match, (void *) (uintptr_t) ++g_timer.generation);
+}
+
+void Chip_TIMER_Disable(LPC_TIMER_T *pTMR)
+{
+    (void) pTMR;
+    g_timer.generation++;
+}
+
+void Chip_TIMER_SetMatch(LPC_TIMER_T *pTMR, int8_t matchnum, uint32_t matchval)
+{
+    (void) pTMR;
+    g_timer.match[matchnum] = matchval;
+}
+
+void Chip_TIMER_MatchEnableInt(LPC_TIMER_T *pTMR, int8_t matchnum)
+{
+    (void) pTMR;
+    g_timer.int_enabled |= (1 << matchnum);
+}
+
+void Chip_TIMER_ResetOnMatchEnable(LPC_TIMER_T *pTMR, int8_t matchnum)
+{
+    (void) pTMR;
+    (void) matchnum;
+}
+
+bool Chip_TIMER_MatchPending(LPC_TIMER_T *pTMR, int8_t matchnum)
+{
+    (void) pTMR;
+    return (matchnum == 1 && g_timer.pending);
+}
+
+void Chip_TIMER_ClearMatch(LPC_TIMER_T *pTMR, int8_t matchnum)
+{
+    (void) pTMR;
+    if (matchnum == 1)
+        g_timer.pending = 0;
+}
@@ -0,0 +1,134 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "chip.h"
+#include "adc.h"
+#include "gpio.h"
+#include "prof.h"
+#include "sched.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+static const gpio_t g_adc_gpio = ADC_PIN;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static void (*g_callback)(uint32_t sum);
+static uint32_t g_sum;
+static volatile uint8_t g_count = ADC_OVERSAMPLE;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void conversion_done(void)
+{
+    uint16_t data;
+
+    // reading the result clears the interrupt
+    if (Chip_ADC_ReadValue(LPC_ADC, ADC_CHANNEL, &data) != SUCCESS)
+        return;
+
+    // a conversion that was running when the burst stopped is discarded
+    if (g_count >= ADC_OVERSAMPLE)
+        return;
+
+    g_sum += data;
+
+    if (++g_count == ADC_OVERSAMPLE)
+    {
+        Chip_ADC_SetBurstCmd(LPC_ADC, DISABLE);
+
+        if (g_callback)
+            g_callback(g_sum);
+    }
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+void adc_init(void (*callback)(uint32_t sum))
+{
+    g_callback = callback;
+
+    // analog function of the pin
+    Chip_IOCON_PinMuxSet(LPC_IOCON, g_adc_gpio.port, g_adc_gpio.pin, IOCON_FUNC1 | IOCON_ADMODE_EN);
+
+    ADC_CLOCK_SETUP_T setup;
+    Chip_ADC_Init(LPC_ADC, &setup);
+    Chip_ADC_SetSampleRate(LPC_ADC, &setup, ADC_SAMPLE_RATE);
+    Chip_ADC_EnableChannel(LPC_ADC, ADC_CHANNEL, ENABLE);
+    Chip_ADC_Int_SetChannelCmd(LPC_ADC, ADC_CHANNEL, ENABLE);
+
+    NVIC_ClearPendingIRQ(ADC_IRQn);
+    NVIC_EnableIRQ(ADC_IRQn);
+
+    // the timer counts microseconds, a match starts each burst
+    Chip_TIMER_Init(LPC_TIMER16_1);
+    Chip_TIMER_Reset(LPC_TIMER16_1);
+    Chip_TIMER_PrescaleSet(LPC_TIMER16_1, (Chip_Clock_GetSystemClockRate() / 1000000) - 1);
+    Chip_TIMER_SetMatch(LPC_TIMER16_1, 0, (1000000 / ADC_BURST_RATE) - 1);
+    Chip_TIMER_MatchEnableInt(LPC_TIMER16_1, 0);
+    Chip_TIMER_ResetOnMatchEnable(LPC_TIMER16_1, 0);
+
+    NVIC_ClearPendingIRQ(TIMER_16_1_IRQn);
+    NVIC_EnableIRQ(TIMER_16_1_IRQn);
+
+    Chip_TIMER_Enable(LPC_TIMER16_1);
+}
+
+void TIMER16_1_IRQHandler(void)
+{
+    sched_irq_entry();
+    if (Chip_TIMER_MatchPending(LPC_TIMER16_1, 0))
+    {
+        Chip_TIMER_ClearMatch(LPC_TIMER16_1, 0);
+
+        // the conversions repeat on their own until the burst is complete
+        g_sum = 0;
+        g_count = 0;
+        Chip_ADC_SetBurstCmd(LPC_ADC, ENABLE);
+    }
+}
+
+void ADC_IRQHandler(void)
+{
+    sched_irq_entry();
+    PROF_ENTER(PROF_ADC);
+    conversion_done();
+    PROF_EXIT(PROF_ADC);
+}
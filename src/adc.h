@@ -0,0 +1,68 @@
+#ifndef ADC_H
+#define ADC_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+// largest sum of the conversions of a burst
+#define ADC_SUM_MAX         (1023 * ADC_OVERSAMPLE)
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// spare analog pin of the expression pedal and its channel (PIO0_23 is AD7)
+#define ADC_PIN             {0, 23}
+#define ADC_CHANNEL         7
+// bursts per second, each one started by the 16-bit timer 1
+#define ADC_BURST_RATE      500
+// conversions of a burst, added together and handed over as one sample
+#define ADC_OVERSAMPLE      16
+// conversions per second within a burst (a conversion takes 11 ADC clocks)
+#define ADC_SAMPLE_RATE     200000
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+// the callback runs in the interrupt of the last conversion of each burst
+void adc_init(void (*callback)(uint32_t sum));
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+#if (ADC_OVERSAMPLE * ADC_BURST_RATE) > (ADC_SAMPLE_RATE / 2)
+#error "ADC_SAMPLE_RATE is too low for the bursts of ADC_OVERSAMPLE conversions"
+#endif
+
+
+#endif
@@ -0,0 +1,108 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "baud.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+// the uart samples each bit 16 times
+#define OVERSAMPLING    16
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// baud = clock / (16 * dl * (1 + divaddval / mulval))
+static uint32_t actual_rate(uint32_t uart_clock, uint32_t dl, uint32_t divaddval, uint32_t mulval)
+{
+    uint64_t den = (uint64_t) OVERSAMPLING * dl * (mulval + divaddval);
+    return (uint32_t) ((((uint64_t) uart_clock * mulval) + (den / 2)) / den);
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+uint32_t baud_divider_calc(uint32_t uart_clock, uint32_t baud_rate, baud_divider_t *divider)
+{
+    uint32_t best_error = 0xFFFFFFFF;
+
+    if (baud_rate == 0)
+        return 0;
+
+    divider->rate = 0;
+
+    // user manual: 1 <= mulval <= 15, 0 <= divaddval < mulval
+    for (uint32_t mulval = 1; mulval <= 15; mulval++)
+    {
+        for (uint32_t divaddval = 0; divaddval < mulval; divaddval++)
+        {
+            // divisor latch rounded to the nearest integer
+            uint64_t den = (uint64_t) OVERSAMPLING * baud_rate * (mulval + divaddval);
+            uint32_t dl = ((((uint64_t) uart_clock * mulval) + (den / 2)) / den);
+
+            // fractional divider requires dl >= 3
+            if (dl < (divaddval ? 3 : 1) || dl > 0xFFFF)
+                continue;
+
+            uint32_t rate = actual_rate(uart_clock, dl, divaddval, mulval);
+            uint32_t error = baud_error_ppm(baud_rate, rate);
+
+            if (error < best_error)
+            {
+                best_error = error;
+                divider->dl = dl;
+                divider->divaddval = divaddval;
+                divider->mulval = mulval;
+                divider->rate = rate;
+            }
+
+            // exact rate, no need to search further
+            if (error == 0)
+                return rate;
+        }
+    }
+
+    return divider->rate;
+}
+
+uint32_t baud_error_ppm(uint32_t baud_rate, uint32_t actual_rate)
+{
+    uint32_t diff = (actual_rate > baud_rate ? actual_rate - baud_rate : baud_rate - actual_rate);
+    return (uint32_t) (((uint64_t) diff * 1000000 + (baud_rate / 2)) / baud_rate);
+}
@@ -0,0 +1,65 @@
+#ifndef BAUD_H
+#define BAUD_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// maximum accepted error between requested and actual baud rate (in parts per million)
+#define BAUD_MAX_ERROR_PPM  15000
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct baud_divider_t {
+    uint16_t dl;
+    uint8_t divaddval, mulval;
+    uint32_t rate;
+} baud_divider_t;
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+// finds the divisor latch and fractional divider that best generates baud_rate from uart_clock
+// returns the closest rate that can be generated, whatever its error (the caller checks it against
+// BAUD_MAX_ERROR_PPM), or zero if no divisor latch fits
+uint32_t baud_divider_calc(uint32_t uart_clock, uint32_t baud_rate, baud_divider_t *divider);
+
+// returns the error of the actual rate in parts per million (always positive)
+uint32_t baud_error_ppm(uint32_t baud_rate, uint32_t actual_rate);
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+
+#endif
@@ -0,0 +1,174 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "chord.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define IN_WINDOW(now, from)    ((uint32_t) ((now) - (from)) < (CHORD_WINDOW * 1000))
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+enum {FOOT_IDLE, FOOT_WAITING, FOOT_SENT, FOOT_CHORD};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct chord_foot_t {
+    // time the press was read, both switches have the same debounce
+    uint32_t press_us;
+    uint8_t state;
+} chord_foot_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static chord_foot_t g_feet[FOOTSWITCHES_COUNT];
+static chord_stats_t g_stats;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void press_sent(chord_foot_t *foot, uint32_t now_us)
+{
+    uint32_t delay = now_us - foot->press_us;
+    if (delay > g_stats.max_delay_us)
+        g_stats.max_delay_us = delay;
+
+    g_stats.deferred++;
+    foot->state = FOOT_SENT;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// the other switch of the chord, -1 if the switch is not part of it
+int chord_other(int foot)
+{
+    if (foot == CHORD_FOOT_A)
+        return CHORD_FOOT_B;
+
+    if (foot == CHORD_FOOT_B)
+        return CHORD_FOOT_A;
+
+    return -1;
+}
+
+// a press that may start a chord is sent at once and taken back if the chord completes (RETRACT),
+// or waits for the window when it can't be taken back (defer), the switches out of the chord are
+// never delayed
+int chord_press(int foot, int defer, uint32_t now_us)
+{
+    int other = chord_other(foot);
+    if (other < 0)
+        return CHORD_SEND;
+
+    chord_foot_t *pressed = &g_feet[foot], *first = &g_feet[other];
+
+    if ((first->state == FOOT_WAITING || first->state == FOOT_SENT) && IN_WINDOW(now_us, first->press_us))
+    {
+        int result = (first->state == FOOT_SENT ? CHORD_RETRACT : CHORD_COMPLETE);
+
+        g_stats.chords++;
+        if (result == CHORD_RETRACT)
+            g_stats.retracted++;
+
+        pressed->state = FOOT_CHORD;
+        first->state = FOOT_CHORD;
+        return result;
+    }
+
+    pressed->press_us = now_us;
+    pressed->state = (defer ? FOOT_WAITING : FOOT_SENT);
+
+    return (defer ? CHORD_WAIT : CHORD_SEND);
+}
+
+// the releases of a chord are not sent (COMPLETE), a press still waiting goes before its release (WAIT)
+int chord_release(int foot, uint32_t now_us)
+{
+    if (chord_other(foot) < 0)
+        return CHORD_SEND;
+
+    chord_foot_t *released = &g_feet[foot];
+    int result = CHORD_SEND;
+
+    if (released->state == FOOT_CHORD)
+    {
+        result = CHORD_COMPLETE;
+    }
+    else if (released->state == FOOT_WAITING)
+    {
+        press_sent(released, now_us);
+        result = CHORD_WAIT;
+    }
+
+    released->state = FOOT_IDLE;
+    return result;
+}
+
+// returns the switches whose waiting presses are no longer part of a chord and are sent now
+uint32_t chord_due(uint32_t now_us)
+{
+    uint32_t due = 0;
+
+    for (int i = 0; i < FOOTSWITCHES_COUNT; i++)
+    {
+        chord_foot_t *foot = &g_feet[i];
+
+        if (foot->state == FOOT_WAITING && !IN_WINDOW(now_us, foot->press_us))
+        {
+            press_sent(foot, now_us);
+            due |= (1 << i);
+        }
+    }
+
+    return due;
+}
+
+// forgets the press of the switch, returns whether it was sent (a waiting one never will be)
+int chord_cancel(int foot)
+{
+    if (chord_other(foot) < 0)
+        return 1;
+
+    chord_foot_t *cancelled = &g_feet[foot];
+    int sent = (cancelled->state == FOOT_SENT);
+
+    cancelled->state = FOOT_IDLE;
+    return sent;
+}
+
+const chord_stats_t *chord_stats(void)
+{
+    return &g_stats;
+}
@@ -0,0 +1,75 @@
+#ifndef CHORD_H
+#define CHORD_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+#include "config.h"
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+// what the caller does with a press or a release
+enum {CHORD_SEND, CHORD_WAIT, CHORD_COMPLETE, CHORD_RETRACT};
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// the two switches of the chord (numbered from 0)
+#define CHORD_FOOT_A        0
+#define CHORD_FOOT_B        3
+// time between the presses of the two switches of a chord (in milliseconds)
+#define CHORD_WINDOW        30
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct chord_stats_t {
+    uint32_t chords, retracted, deferred;
+    // worst-case time a press waited for the chord window
+    uint32_t max_delay_us;
+} chord_stats_t;
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+int chord_other(int foot);
+int chord_press(int foot, int defer, uint32_t now_us);
+int chord_release(int foot, uint32_t now_us);
+uint32_t chord_due(uint32_t now_us);
+int chord_cancel(int foot);
+const chord_stats_t *chord_stats(void);
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+#if CHORD_FOOT_A == CHORD_FOOT_B || CHORD_FOOT_A >= FOOTSWITCHES_COUNT || CHORD_FOOT_B >= FOOTSWITCHES_COUNT
+#error "CHORD_FOOT_A and CHORD_FOOT_B must be two different footswitches"
+#endif
+
+
+#endif
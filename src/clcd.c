@@ -30,6 +30,7 @@
 */
 
 #include "clcd.h"
+#include "prof.h"
 
 
 /*
@@ -262,11 +263,15 @@ void clcd_clear(int lcd_id)
 
 void clcd_print(int lcd_id, const char *str)
 {
+    PROF_ENTER(PROF_CLCD_PRINT);
+
     clcd_t *lcd = &g_lcds[lcd_id];
     const char *pstr = str;
 
     while (*pstr)
         lcd_send(lcd, *pstr++, LCD_DATA);
+
+    PROF_EXIT(PROF_CLCD_PRINT);
 }
 
 void clcd_cursor_set(int lcd_id, int line, int col)
@@ -0,0 +1,212 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "coalescer.h"
+#include "hardware.h"
+#include "latency.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct pending_t {
+    float value[COALESCER_QUEUE_SIZE];
+    uint8_t type[COALESCER_QUEUE_SIZE];
+    uint8_t count;
+    volatile uint8_t in_flight;
+    // values refused while the queue was full leave the actuator at the last one
+    uint8_t refused, refused_type;
+    float refused_value;
+} pending_t;
+
+// first edge times of the queued values of a timed actuator
+typedef struct timed_t {
+    uint32_t time[COALESCER_QUEUE_SIZE];
+    uint32_t refused_time;
+    // actuator that sends the time along with the value, none when negative
+    int8_t actuator;
+} timed_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static float *g_values;
+static int g_count;
+static pending_t g_pending[COALESCER_MAX_ACTUATORS];
+static timed_t g_timed[COALESCER_TIMED_ACTUATORS];
+static uint32_t g_merged, g_refused;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// count can't be over COALESCER_MAX_ACTUATORS
+void coalescer_init(float *values, int count)
+{
+    g_values = values;
+    g_count = count;
+
+    for (int i = 0; i < COALESCER_TIMED_ACTUATORS; i++)
+        g_timed[i].actuator = -1;
+}
+
+void coalescer_push(int actuator, float value, int type)
+{
+    coalescer_push_timed(actuator, value, type, 0);
+}
+
+// time_us is the time of the first edge of the switch on the hw_time_us clock, it is only kept for
+// the timed actuators
+void coalescer_push_timed(int actuator, float value, int type, uint32_t time_us)
+{
+    if (actuator >= g_count)
+        return;
+
+    pending_t *pending = &g_pending[actuator];
+    timed_t *timed = (actuator < COALESCER_TIMED_ACTUATORS ? &g_timed[actuator] : 0);
+    int last = pending->count - 1;
+
+    // a level value replaces the previous level value, edges are always kept
+    if (last >= 0 && type == COALESCER_LEVEL && pending->type[last] == COALESCER_LEVEL)
+    {
+        pending->value[last] = value;
+        if (timed)
+            timed->time[last] = time_us;
+
+        g_merged++;
+        return;
+    }
+
+    // queue is full, the queued edges are kept and the new value waits for room
+    if (pending->count == COALESCER_QUEUE_SIZE)
+    {
+        pending->refused = 1;
+        pending->refused_value = value;
+        pending->refused_type = type;
+        if (timed)
+            timed->refused_time = time_us;
+
+        g_refused++;
+        return;
+    }
+
+    pending->value[pending->count] = value;
+    pending->type[pending->count] = type;
+    if (timed)
+        timed->time[pending->count] = time_us;
+
+    pending->count++;
+}
+
+// the time of each value committed on a timed actuator is written to time_actuator, which must be
+// out of the coalescer count so nothing else writes it
+void coalescer_time_actuator(int actuator, int time_actuator)
+{
+    if (actuator < COALESCER_TIMED_ACTUATORS)
+        g_timed[actuator].actuator = time_actuator;
+}
+
+// must be called before cc_process, so all the committed values go in the same frame
+void coalescer_commit(void)
+{
+    for (int i = 0; i < g_count; i++)
+    {
+        pending_t *pending = &g_pending[i];
+        timed_t *timed = (i < COALESCER_TIMED_ACTUATORS ? &g_timed[i] : 0);
+
+        // at most one value per actuator until the previous one is sent
+        if (pending->count == 0 || pending->in_flight)
+            continue;
+
+        float value = pending->value[0];
+        uint32_t time_us = (timed ? timed->time[0] : 0);
+
+        pending->count--;
+        for (int j = 0; j < pending->count; j++)
+        {
+            pending->value[j] = pending->value[j + 1];
+            pending->type[j] = pending->type[j + 1];
+            if (timed)
+                timed->time[j] = timed->time[j + 1];
+        }
+
+        // the refused values are lost, but not the state they left: a press refused along with
+        // its release leaves nothing to send, a lone refused release is sent when there is room
+        if (pending->refused)
+        {
+            pending->refused = 0;
+            if (pending->refused_value != pending->value[pending->count - 1])
+            {
+                pending->value[pending->count] = pending->refused_value;
+                pending->type[pending->count] = pending->refused_type;
+                if (timed)
+                    timed->time[pending->count] = timed->refused_time;
+
+                pending->count++;
+            }
+        }
+
+        // the library only sends an update when the value changes
+        if (g_values[i] != value)
+        {
+            g_values[i] = value;
+            pending->in_flight = 1;
+            latency_stage(i, LAT_WRITE);
+
+            // microseconds are exact in a float up to 16 s
+            if (timed && timed->actuator >= 0)
+                g_values[timed->actuator] = (float) (hw_time_us() - time_us);
+        }
+    }
+}
+
+// must be called when a frame is sent to the master
+void coalescer_flushed(void)
+{
+    for (int i = 0; i < g_count; i++)
+        g_pending[i].in_flight = 0;
+}
+
+uint32_t coalescer_merged(void)
+{
+    return g_merged;
+}
+
+uint32_t coalescer_refused(void)
+{
+    return g_refused;
+}
@@ -0,0 +1,68 @@
+#ifndef COALESCER_H
+#define COALESCER_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+#include "config.h"
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+enum {COALESCER_LEVEL, COALESCER_EDGE};
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// maximum number of actuators handled by the coalescer (all but the edge times, which are written
+// along with the values of the pages)
+#define COALESCER_MAX_ACTUATORS     EDGE_TIME_ACTUATOR(0)
+// actuators whose values carry the time of their switch edge, the first ones (the pages)
+#define COALESCER_TIMED_ACTUATORS   ACTUATORS_COUNT
+// number of values that can wait per actuator (edges are never merged)
+#define COALESCER_QUEUE_SIZE        4
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+void coalescer_init(float *values, int count);
+void coalescer_push(int actuator, float value, int type);
+void coalescer_push_timed(int actuator, float value, int type, uint32_t time_us);
+void coalescer_time_actuator(int actuator, int time_actuator);
+void coalescer_commit(void);
+void coalescer_flushed(void);
+uint32_t coalescer_merged(void);
+uint32_t coalescer_refused(void);
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+
+#endif
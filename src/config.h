@@ -3,6 +3,21 @@
 
 
 #define FOOTSWITCHES_COUNT  4
+// pages of assignments, the footswitches control the actuators of the current page
+#define PAGES_COUNT         3
+#define ACTUATORS_COUNT     (FOOTSWITCHES_COUNT * PAGES_COUNT)
+// long press, double tap and repeat actuators of each footswitch, shared by the pages
+#define GESTURE_ACTUATORS_COUNT (FOOTSWITCHES_COUNT * 3)
+// expression pedal on the analog input
+#define EXPRESSION_ACTUATOR     (ACTUATORS_COUNT + GESTURE_ACTUATORS_COUNT)
+// edge time of each footswitch, the last actuators: microseconds from the first edge of the last
+// press or release until its value was put in the frame, sent along with it
+#define EDGE_TIME_ACTUATOR(foot)    (EXPRESSION_ACTUATOR + 1 + (foot))
+// largest edge time (in microseconds), exact in a float
+#define EDGE_TIME_MAX               16777216.0
+// modes whose presses on a chord switch wait for the chord window (see src/chord.h), the presses
+// of the other assignments are sent at once and taken back when the chord completes
+#define CHORD_DEFER_MODES   (CC_MODE_TOGGLE | CC_MODE_TRIGGER | CC_MODE_OPTIONS | CC_MODE_TAP_TEMPO)
 // define firmware version
 #define CC_FIRMWARE_MAJOR   0
 #define CC_FIRMWARE_MINOR   4
@@ -11,12 +26,21 @@
 // maximum number of devices that can be created
 #define CC_MAX_DEVICES          1
 // maximum number of actuators that can be created per device
-#define CC_MAX_ACTUATORS        4
+// each takes 48 bytes of the firmware tables (72 for the pages, 20 for the edge times) and its
+// share of the library ones (see README.md)
+#define CC_MAX_ACTUATORS        EDGE_TIME_ACTUATOR(FOOTSWITCHES_COUNT)
 // maximum number of assignments that can be created per actuator
 #define CC_MAX_ASSIGNMENTS      1
 // maximum number of options items that can be created per device
 #define CC_MAX_OPTIONS_ITEMS    64
 
+// time that the welcome message is shown (in milliseconds)
+#define WELCOME_TIMEOUT         3000
+
+// time that the assignments restored from the EEPROM wait to be sent again by the host,
+// counted from the first message received (in milliseconds)
+#define STORE_RECONCILE_TIMEOUT 5000
+
 //// Tap Tempo
 // defines the time that the led will stay turned on (in milliseconds)
 #define TAP_TEMPO_TIME_ON         100
@@ -30,6 +54,14 @@
 //amount of colours available for LED cycling
 #define LED_COLOURS_AMOUNT		7
 
+// baud rates that the device steps through, in order, when the master can't be understood
+// the master negotiates a rate by sending at the highest rate it and the cable support
+// rates that can't be generated within BAUD_MAX_ERROR_PPM are skipped
+#define SERIAL_BAUD_RATES       {CC_BAUD_RATE_FALLBACK, CC_BAUD_RATE, 500000, 1000000}
+// once the master answered at a rate the device stays there through parse errors, it steps again
+// only after the master was silent this long (in milliseconds)
+#define SERIAL_BAUD_LOCK_TIMEOUT    1000
+
 // define the size of the queue used to store the updates before send them
 #define CC_UPDATES_FIFO_SIZE    10
 
@@ -220,6 +220,26 @@ void bss_init(unsigned int start, unsigned int len) {
         *pulDest++ = 0;
 }
 
+//*****************************************************************************
+// Fills the RAM between the end of the data sections and the current stack
+// pointer with a pattern, so the stack high-water mark can be found at run
+// time (see hw_stack_free). The pattern must match STACK_PAINT in hardware.h
+//*****************************************************************************
+#define STACK_PAINT 0xA5A5A5A5
+
+extern unsigned int _pvHeapStart;
+
+__attribute__ ((section(".after_vectors")))
+void stack_paint(void) {
+    unsigned int *pulDest = &_pvHeapStart;
+    unsigned int *sp;
+    __asm volatile ("mov %0, sp" : "=r" (sp));
+    // keep the frame of this function untouched
+    sp -= 16;
+    while (pulDest < sp)
+        *pulDest++ = STACK_PAINT;
+}
+
 //*****************************************************************************
 // The following symbols are constructs generated by the linker, indicating
 // the location of various points in the "Global Section Table". This table is
@@ -272,6 +292,11 @@ ResetISR(void) {
         bss_init(ExeAddr, SectionLen);
     }
 
+    // Paint the unused stack area
+#if !defined (DONT_PAINT_STACK)
+    stack_paint();
+#endif
+
     // Patch the AEABI integer divide functions to use MCU's romdivide library
 #ifdef __USE_ROMDIVIDE
     // Get address of Integer division routines function table in ROM
@@ -7,6 +7,7 @@
 #include "delay.h"
 #include "chip.h"
 #include "hardware.h"
+#include "prof.h"
 
 
 /*
@@ -64,6 +65,7 @@ inline void delay_us(uint32_t us)
      * for Teensy 3.0 (http://www.pjrc.com/)
      */
     if (us == 0) return;
+    PROF_ENTER(PROF_DELAY_US);
 #ifndef CCC_ANALYZER
     uint32_t n = us * g_factor;
     asm(".syntax unified");
@@ -75,6 +77,7 @@ inline void delay_us(uint32_t us)
     );
     asm(".syntax divided");
 #endif
+    PROF_EXIT(PROF_DELAY_US);
 }
 
 void delay_ms(uint32_t ms)
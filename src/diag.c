@@ -0,0 +1,117 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <string.h>
+#include "diag.h"
+#include "hardware.h"
+
+#ifdef DIAG
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static void (*g_write_cb)(const uint8_t *data, uint32_t size);
+static uint32_t g_counters;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void put_u32(uint8_t *buffer, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        buffer[i] = (value >> (i * 8)) & 0xFF;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// header: magic, uptime in milliseconds
+// counter: name (8 bytes), value, all little endian
+// end: empty name, number of counters
+void diag_begin(void (*write_cb)(const uint8_t *data, uint32_t size))
+{
+    uint8_t buffer[8];
+
+    g_write_cb = write_cb;
+    g_counters = 0;
+
+    memcpy(buffer, DIAG_MAGIC, 4);
+    put_u32(&buffer[4], hw_uptime());
+    write_cb(buffer, sizeof(buffer));
+}
+
+void diag_counter(const char *name, uint32_t value)
+{
+    uint8_t buffer[DIAG_NAME_SIZE + 4];
+
+    memset(buffer, 0, DIAG_NAME_SIZE);
+    strncpy((char *) buffer, name, DIAG_NAME_SIZE);
+    put_u32(&buffer[DIAG_NAME_SIZE], value);
+    g_write_cb(buffer, sizeof(buffer));
+    g_counters++;
+}
+
+// counter of one of several owners (task, actuator), named "owner.name", e.g. "leds.lat"
+void diag_counter_of(const char *owner, const char *name, uint32_t value)
+{
+    char full[DIAG_NAME_SIZE + 1];
+    int size = 0;
+
+    while (size < DIAG_OWNER_SIZE && owner[size])
+    {
+        full[size] = owner[size];
+        size++;
+    }
+
+    full[size++] = '.';
+    strncpy(&full[size], name, DIAG_NAME_SIZE - size);
+    full[DIAG_NAME_SIZE] = 0;
+
+    diag_counter(full, value);
+}
+
+void diag_end(void)
+{
+    uint8_t buffer[DIAG_NAME_SIZE + 4];
+
+    memset(buffer, 0, DIAG_NAME_SIZE);
+    put_u32(&buffer[DIAG_NAME_SIZE], g_counters);
+    g_write_cb(buffer, sizeof(buffer));
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef DIAG_H
+#define DIAG_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+// dump header
+#define DIAG_MAGIC          "CCDG"
+// counter names are padded with zeros, an empty name ends the dump
+#define DIAG_NAME_SIZE      8
+// characters of the owner kept in the name of its counters, see diag_counter_of
+#define DIAG_OWNER_SIZE     4
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// time without data from the master before the dump is sent (in milliseconds)
+#define DIAG_QUIET_TIME     1000
+// the dump is sent in parts of this size, each one once the serial driver took the previous ones
+#define DIAG_PART_SIZE      64
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+#ifdef DIAG
+void diag_begin(void (*write_cb)(const uint8_t *data, uint32_t size));
+void diag_counter(const char *name, uint32_t value);
+void diag_counter_of(const char *owner, const char *name, uint32_t value);
+void diag_end(void);
+#endif
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+
+#endif
@@ -0,0 +1,130 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "expression.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+// the filter keeps 8 fractional bits, the small steps of a slow pedal are not lost
+#define FILTER_FRACTION     8
+// samples are scaled to positions with a multiplication, no division per sample
+#define SCALE_SHIFT         12
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static uint32_t g_scale;
+static uint32_t g_filter;
+static int32_t g_held, g_sent = -1;
+static expression_stats_t g_stats;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static int32_t output(int32_t held)
+{
+    if (held < EXPRESSION_END_ZONE)
+        return 0;
+
+    if (held > (EXPRESSION_MAX - EXPRESSION_END_ZONE))
+        return EXPRESSION_MAX;
+
+    return held;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// sample_max is the sample of a pedal at the end of its travel
+void expression_init(uint32_t sample_max)
+{
+    g_scale = ((uint32_t) EXPRESSION_MAX << SCALE_SHIFT) / sample_max;
+    g_sent = -1;
+}
+
+// runs the filter, returns 1 when an update has to be sent
+int expression_sample(uint32_t sample)
+{
+    int32_t position = (sample * g_scale) >> SCALE_SHIFT;
+    if (position > EXPRESSION_MAX)
+        position = EXPRESSION_MAX;
+
+    g_stats.samples++;
+
+    // the first sample is where the pedal is, the filter doesn't ramp from the heel
+    if (g_sent < 0)
+    {
+        g_filter = (uint32_t) position << FILTER_FRACTION;
+        g_held = position;
+        g_sent = output(position);
+        g_stats.updates++;
+        return 1;
+    }
+
+    g_filter += (((int32_t) (position << FILTER_FRACTION)) - (int32_t) g_filter) >> EXPRESSION_FILTER_SHIFT;
+    int32_t filtered = g_filter >> FILTER_FRACTION;
+
+    // the output stays until the noise of the filtered position goes past the hysteresis
+    if (filtered > g_held + EXPRESSION_HYSTERESIS)
+        g_held = filtered - EXPRESSION_HYSTERESIS;
+    else if (filtered < g_held - EXPRESSION_HYSTERESIS)
+        g_held = filtered + EXPRESSION_HYSTERESIS;
+
+    int32_t value = output(g_held);
+    int32_t moved = (value > g_sent ? value - g_sent : g_sent - value);
+
+    // the ends are always sent, the pedal parked at the heel reads exactly 0
+    if (moved >= EXPRESSION_DEADBAND || (moved > 0 && (value == 0 || value == EXPRESSION_MAX)))
+    {
+        g_sent = value;
+        g_stats.updates++;
+        return 1;
+    }
+
+    return 0;
+}
+
+// last position to be sent
+uint16_t expression_value(void)
+{
+    return (g_sent < 0 ? 0 : g_sent);
+}
+
+const expression_stats_t *expression_stats(void)
+{
+    return &g_stats;
+}
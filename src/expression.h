@@ -0,0 +1,74 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+// positions go from 0 (heel down) to EXPRESSION_MAX (toe down)
+#define EXPRESSION_MAX      65535
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// one-pole low-pass, each sample moves the filter by 1/2^EXPRESSION_FILTER_SHIFT of the distance,
+// a time constant of 8 samples (16 ms at 500 samples per second)
+#define EXPRESSION_FILTER_SHIFT     3
+// the filtered position has to move this far before the output follows it (hysteresis)
+#define EXPRESSION_HYSTERESIS       128
+// an update is sent when the output moved this far from the last one sent (deadband)
+#define EXPRESSION_DEADBAND         256
+// travel at each end that reads as the end itself, a worn pedal still reaches 0 and 1
+#define EXPRESSION_END_ZONE         512
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct expression_stats_t {
+    uint32_t samples, updates;
+} expression_stats_t;
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+void expression_init(uint32_t sample_max);
+int expression_sample(uint32_t sample);
+uint16_t expression_value(void);
+const expression_stats_t *expression_stats(void);
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+#if EXPRESSION_HYSTERESIS >= EXPRESSION_END_ZONE
+#error "EXPRESSION_END_ZONE must be larger than EXPRESSION_HYSTERESIS to reach the ends"
+#endif
+
+
+#endif
@@ -0,0 +1,176 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "gesture.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define ELAPSED(now, from, ms)      ((uint32_t) ((now) - (from)) >= ((uint32_t) (ms) * 1000))
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+static const gesture_config_t g_configs[FOOTSWITCHES_COUNT] = {GESTURE_SWITCHES};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct gesture_state_t {
+    uint32_t press_us, release_us, repeat_us;
+    uint8_t held, long_on;
+    // the last press was a short one, a press in time makes it a double tap
+    uint8_t tapped;
+} gesture_state_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static gesture_state_t g_states[FOOTSWITCHES_COUNT];
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// the press itself is sent right away by the caller, a double tap is recognised at the second
+// press and the end of a long press at the release
+int gesture_edge(int foot, int pressed, uint32_t time_us)
+{
+    if (foot >= FOOTSWITCHES_COUNT)
+        return 0;
+
+    const gesture_config_t *config = &g_configs[foot];
+    gesture_state_t *state = &g_states[foot];
+    int gestures = 0;
+
+    if (pressed)
+    {
+        if (state->tapped && config->double_ms && !ELAPSED(time_us, state->release_us, config->double_ms))
+        {
+            gestures |= (1 << GESTURE_DOUBLE);
+
+            // a third press starts a new double tap
+            state->tapped = 0;
+        }
+        else
+        {
+            state->tapped = 1;
+        }
+
+        state->press_us = time_us;
+        state->held = 1;
+    }
+    else
+    {
+        if (state->long_on)
+            gestures |= (1 << GESTURE_LONG);
+
+        // only a short press can be the first tap of a double tap
+        if (!state->held || state->long_on)
+            state->tapped = 0;
+
+        state->release_us = time_us;
+        state->held = 0;
+        state->long_on = 0;
+    }
+
+    return gestures;
+}
+
+// long press and repeats of a held switch, called every few milliseconds
+int gesture_poll(int foot, uint32_t now_us)
+{
+    if (foot >= FOOTSWITCHES_COUNT)
+        return 0;
+
+    const gesture_config_t *config = &g_configs[foot];
+    gesture_state_t *state = &g_states[foot];
+    int gestures = 0;
+
+    if (!state->held || !config->long_ms)
+        return 0;
+
+    if (!state->long_on)
+    {
+        if (!ELAPSED(now_us, state->press_us, config->long_ms))
+            return 0;
+
+        gestures |= (1 << GESTURE_LONG);
+        state->long_on = 1;
+        state->repeat_us = state->press_us + (config->long_ms * 1000);
+    }
+
+    // the repeats keep the period of the long press, a late poll doesn't shift them
+    if (config->repeat_ms && ELAPSED(now_us, state->repeat_us, config->repeat_ms))
+    {
+        gestures |= (1 << GESTURE_REPEAT);
+        state->repeat_us += (config->repeat_ms * 1000);
+    }
+
+    return gestures;
+}
+
+// time until the next long press or repeat of the held switch (in microseconds), zero if none
+// is coming, so the switch is only polled when a gesture is due
+uint32_t gesture_next(int foot, uint32_t now_us)
+{
+    if (foot >= FOOTSWITCHES_COUNT)
+        return 0;
+
+    const gesture_config_t *config = &g_configs[foot];
+    gesture_state_t *state = &g_states[foot];
+    uint32_t due_us;
+
+    if (!state->held || !config->long_ms)
+        return 0;
+
+    if (!state->long_on)
+        due_us = state->press_us + (config->long_ms * 1000);
+    else if (config->repeat_ms)
+        due_us = state->repeat_us + (config->repeat_ms * 1000);
+    else
+        return 0;
+
+    // already due, the next poll sends it
+    int32_t delay_us = (int32_t) (due_us - now_us);
+    return (delay_us > 0 ? (uint32_t) delay_us : 1);
+}
+
+// the switch became part of something else (a chord), its press is no gesture
+void gesture_cancel(int foot)
+{
+    if (foot >= FOOTSWITCHES_COUNT)
+        return;
+
+    g_states[foot].held = 0;
+    g_states[foot].tapped = 0;
+}
@@ -0,0 +1,74 @@
+#ifndef GESTURE_H
+#define GESTURE_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+#include "config.h"
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+enum {GESTURE_LONG, GESTURE_DOUBLE, GESTURE_REPEAT};
+#define GESTURES_COUNT      3
+
+// actuator of a gesture of a footswitch, after the actuators of the pages
+#define GESTURE_ACTUATOR(gesture, foot)     (ACTUATORS_COUNT + ((gesture) * FOOTSWITCHES_COUNT) + (foot))
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// long press, double tap and repeat times of each switch (in milliseconds, 0 disables the gesture)
+// the long press is the hold time, the double tap the time from the release to the second press
+// and the repeat the period of the repeats that follow a long press
+#define GESTURE_SWITCHES    {600, 300, 150}, {600, 300, 150}, {600, 300, 150}, {600, 300, 150}
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct gesture_config_t {
+    uint16_t long_ms, double_ms, repeat_ms;
+} gesture_config_t;
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+// return a bit per gesture (1 << GESTURE_*)
+int gesture_edge(int foot, int pressed, uint32_t time_us);
+int gesture_poll(int foot, uint32_t now_us);
+uint32_t gesture_next(int foot, uint32_t now_us);
+void gesture_cancel(int foot);
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+#if GESTURE_ACTUATORS_COUNT != (FOOTSWITCHES_COUNT * GESTURES_COUNT)
+#error "GESTURE_ACTUATORS_COUNT must have one actuator per gesture of each footswitch"
+#endif
+
+
+#endif
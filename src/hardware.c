@@ -10,6 +10,9 @@
 #include "gpio.h"
 #include "delay.h"
 #include "clcd.h"
+#include "latency.h"
+#include "prof.h"
+#include "sched.h"
 
 /*
 ****************************************************************************************************
@@ -42,7 +45,10 @@ static const gpio_t g_backlights_gpio[] = {BACKLIGHTS_PINS};
 
 typedef struct button_t {
     int state, event;
-    unsigned int count;
+    unsigned int count, idle;
+    volatile uint8_t edge_pending;
+    volatile uint32_t edge_time;
+    uint32_t event_time, read_time;
 } button_t;
 
 typedef struct blinking_led_t {
@@ -58,9 +64,12 @@ typedef struct blinking_led_t {
 */
 
 static button_t g_buttons[N_BUTTONS];
-static uint32_t g_counter;
+static volatile uint32_t g_counter;
+static uint32_t g_ticks_per_us;
 static uint8_t g_self_test;
 static blinking_led_t g_blinking_led[N_LEDS];
+static void (*g_button_cb)(void);
+static void (*g_led_cb)(void);
 
 /*
 ****************************************************************************************************
@@ -68,10 +77,13 @@ static blinking_led_t g_blinking_led[N_LEDS];
 ****************************************************************************************************
 */
 
-// buttons + led proces
+// buttons process
 void SysTick_Handler(void)
 {
+    // the stamp counts the millisecond that just started
     g_counter++;
+    sched_irq_entry();
+    PROF_ENTER(PROF_SYSTICK);
 
     for (uint8_t i = 0; i < N_BUTTONS; i++)
     {
@@ -79,76 +91,96 @@ void SysTick_Handler(void)
         button_t *button = &g_buttons[i];
 
         int value = (Chip_GPIO_GetPinState(LPC_GPIO, gpio->port, gpio->pin) == 0 ? 1 : 0);
-        if (value)
+        if (value != button->state)
         {
-            if (button->state == BUTTON_RELEASED)
+            button->idle = 0;
+            button->count++;
+            if (button->count >= BUTTON_DEBOUNCE)
             {
-                button->count++;
-                if (button->count >= BUTTON_DEBOUNCE)
-                {
-                    button->count = 0;
-                    button->state = BUTTON_PRESSED;
-                    button->event = BUTTON_PRESSED;
-                }
+                button->count = 0;
+                button->state = value;
+                button->event = value;
+
+                // the event happened at the first edge of the bounce sequence
+                button->event_time = (button->edge_pending ? button->edge_time : hw_time_us());
+                button->edge_pending = 0;
+                latency_edge(i, button->event_time, hw_time_us());
+
+                if (g_button_cb)
+                    g_button_cb();
             }
         }
         else
         {
-            if (button->state == BUTTON_PRESSED)
-            {
-                button->count++;
-                if (button->count >= BUTTON_DEBOUNCE)
-                {
-                    button->count = 0;
-                    button->state = BUTTON_RELEASED;
-                    button->event = BUTTON_RELEASED;
-                }
-            }
+            // pin went back to the stable state, the edge was a glitch
+            if (++button->idle >= BUTTON_DEBOUNCE)
+                button->edge_pending = 0;
         }
     }
 
-    for (uint8_t i = 0; i < N_LEDS; i++)
+    PROF_EXIT(PROF_SYSTICK);
+}
+
+// reads the milliseconds counter and the systick cycles elapsed in the current millisecond
+static uint32_t read_time(uint32_t *ms)
+{
+    uint32_t counter, ticks;
+
+    do
     {
-        blinking_led_t *led = &g_blinking_led[i];
+        counter = g_counter;
+        *ms = counter;
+        ticks = SysTick->VAL;
 
-        if ((led->on_time != 0) && (led->off_time != 0))
+        // systick wrapped but its handler didn't run yet
+        if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
         {
-            //blink get current time
-            if (led->time == 0)
-                led->time = hw_uptime();
+            ticks = SysTick->VAL;
+            (*ms)++;
+        }
+    } while (counter != g_counter);
 
-            //on or off
-            if ((hw_uptime() - led->time) > led->on_time)
-            {
-                //turn led off
-                if (led->state == LED_ON)
-                {
-                    led->state = LED_OFF;
-                    for (uint8_t j=0; j < 3; j++)
-                    {
-                        if (led->color[j] != -1)
-                            hw_led(i, led->color[j], led->state);
-                    }
-                }
-            }
+    return SysTick->LOAD - ticks;
+}
 
-            if ((hw_uptime() - led->time) > (led->off_time + led->on_time))
-            {
-                //turn led off
-                if (led->state == LED_OFF)
-                {
-                    led->state = LED_ON;
-                    for (uint8_t j=0; j < 3; j++)
-                    {
-                        if (led->color[j] != -1)
-                            hw_led(i, led->color[j], led->state);
-                    }
-                }
+// stamps the first edge of each bounce sequence
+static void button_edge(uint8_t i)
+{
+    sched_irq_entry();
+    PROF_ENTER(PROF_PININT);
+    Chip_PININT_ClearIntStatus(LPC_PININT, PININTCH(i));
 
-                led->time = 0;
-            }
-        }
+    button_t *button = &g_buttons[i];
+    if (!button->edge_pending)
+    {
+        button->edge_time = hw_time_us();
+        button->edge_pending = 1;
     }
+
+    // the stable time of a glitch counts from its last edge, edges between two ticks are not seen
+    // by the debouncer
+    button->idle = 0;
+    PROF_EXIT(PROF_PININT);
+}
+
+void FLEX_INT0_IRQHandler(void)
+{
+    button_edge(0);
+}
+
+void FLEX_INT1_IRQHandler(void)
+{
+    button_edge(1);
+}
+
+void FLEX_INT2_IRQHandler(void)
+{
+    button_edge(2);
+}
+
+void FLEX_INT3_IRQHandler(void)
+{
+    button_edge(3);
 }
 
 // read unique id via IAP
@@ -214,11 +246,20 @@ void hw_init(void)
     }
 
     // buttons
+    Chip_Clock_EnablePeriphClock(SYSCTL_CLOCK_PINT);
     for (uint8_t i = 0; i < N_BUTTONS; i++)
     {
         const gpio_t *gpio = &g_buttons_gpio[i];
         Chip_GPIO_SetPinDIRInput(LPC_GPIO, gpio->port, gpio->pin);
         g_buttons[i].event = -1;
+
+        // both edges generate an interrupt used to timestamp the button events
+        Chip_SYSCTL_SetPinInterrupt(i, gpio->port, gpio->pin);
+        Chip_PININT_SetPinModeEdge(LPC_PININT, PININTCH(i));
+        Chip_PININT_EnableIntHigh(LPC_PININT, PININTCH(i));
+        Chip_PININT_EnableIntLow(LPC_PININT, PININTCH(i));
+        Chip_PININT_ClearIntStatus(LPC_PININT, PININTCH(i));
+        NVIC_EnableIRQ(PIN_INT0_IRQn + i);
     }
 
     // LCD
@@ -236,6 +277,7 @@ void hw_init(void)
     }
 
     SysTick_Config(SystemCoreClock / 1000);
+    g_ticks_per_us = SystemCoreClock / 1000000;
 
     // init random generator
     srand(generate_seed());
@@ -253,10 +295,34 @@ int hw_button(int button)
 {
     int event = g_buttons[button].event;
     g_buttons[button].event = -1;
+    g_buttons[button].read_time = g_buttons[button].event_time;
 
     return event;
 }
 
+int hw_button_state(int button)
+{
+    return g_buttons[button].state;
+}
+
+// nonzero when no switch is pressed, bouncing or waiting for its debounce, so no button event can
+// come for the debounce time
+int hw_buttons_idle(void)
+{
+    for (uint8_t i = 0; i < N_BUTTONS; i++)
+    {
+        if (g_buttons[i].state || g_buttons[i].edge_pending)
+            return 0;
+    }
+
+    return 1;
+}
+
+uint32_t hw_button_time(int button)
+{
+    return g_buttons[button].read_time;
+}
+
 void hw_led(int led, int color, int value)
 {
     const gpio_t *l = &g_leds_gpio[(led * 3) + color];
@@ -332,6 +398,10 @@ void hw_led_set(int led, int color, int value, int on_time_ms, int off_time_ms)
     {
         g_blinking_led[led].color[q] = colors[q];
     }
+
+    // the blinking is timed by hw_led_process
+    if (on_time_ms != 0 && off_time_ms != 0 && g_led_cb)
+        g_led_cb();
 }
 
 
@@ -340,6 +410,153 @@ inline uint32_t hw_uptime(void)
     return g_counter;
 }
 
+// returns the time until the next change of a blinking LED (in milliseconds), zero if none blinks
+uint32_t hw_led_process(void)
+{
+    uint32_t next = 0;
+
+    for (uint8_t i = 0; i < N_LEDS; i++)
+    {
+        blinking_led_t *led = &g_blinking_led[i];
+
+        if ((led->on_time != 0) && (led->off_time != 0))
+        {
+            //blink get current time
+            if (led->time == 0)
+                led->time = hw_uptime();
+
+            //on or off
+            if ((hw_uptime() - led->time) > led->on_time)
+            {
+                //turn led off
+                if (led->state == LED_ON)
+                {
+                    led->state = LED_OFF;
+                    for (uint8_t j=0; j < 3; j++)
+                    {
+                        if (led->color[j] != -1)
+                            hw_led(i, led->color[j], led->state);
+                    }
+                }
+            }
+
+            if ((hw_uptime() - led->time) > (led->off_time + led->on_time))
+            {
+                //turn led off
+                if (led->state == LED_OFF)
+                {
+                    led->state = LED_ON;
+                    for (uint8_t j=0; j < 3; j++)
+                    {
+                        if (led->color[j] != -1)
+                            hw_led(i, led->color[j], led->state);
+                    }
+                }
+
+                led->time = 0;
+            }
+
+            // on until on_time elapsed, off until the period elapsed, the next period starts a tick
+            // after
+            uint32_t elapsed = hw_uptime() - led->time, delay;
+            if (led->time == 0)
+                delay = 1;
+            else if (led->state == LED_ON && elapsed <= led->on_time)
+                delay = led->on_time - elapsed + 1;
+            else
+                delay = led->off_time + led->on_time - elapsed + 1;
+
+            if (next == 0 || delay < next)
+                next = delay;
+        }
+    }
+
+    return next;
+}
+
+void hw_button_notify(void (*callback)(void))
+{
+    g_button_cb = callback;
+}
+
+void hw_led_notify(void (*callback)(void))
+{
+    g_led_cb = callback;
+}
+
+uint32_t hw_time_us(void)
+{
+    uint32_t ms, ticks = read_time(&ms);
+    return (ms * 1000) + (ticks / g_ticks_per_us);
+}
+
+uint32_t hw_cycles_per_ms(void)
+{
+    return SysTick->LOAD + 1;
+}
+
+uint32_t hw_cycles(void)
+{
+    uint32_t ms, ticks = read_time(&ms);
+    return (ms * (SysTick->LOAD + 1)) + ticks;
+}
+
+// the startup code paints the stack area, the high-water mark is the first word that changed
+uint32_t hw_stack_free(void)
+{
+#if !defined(CCC_ANALYZER) && !defined(SIM)
+    extern uint32_t _pvHeapStart;
+    extern uint32_t _vStackTop;
+
+    const uint32_t *bottom = &_pvHeapStart, *p = bottom;
+    while (p < &_vStackTop && *p == STACK_PAINT)
+        p++;
+
+    return (p - bottom) * sizeof(uint32_t);
+#else
+    return 0;
+#endif
+}
+
+uint32_t hw_stack_size(void)
+{
+#if !defined(CCC_ANALYZER) && !defined(SIM)
+    extern uint32_t _pvHeapStart;
+    extern uint32_t _vStackTop;
+
+    return (&_vStackTop - &_pvHeapStart) * sizeof(uint32_t);
+#else
+    return 0;
+#endif
+}
+
+// EEPROM access via IAP, returns the IAP status (0 on success)
+static int eeprom_command(unsigned int command, uint32_t address, void *data, uint32_t size)
+{
+    unsigned int param_table[5];
+    unsigned int result_table[5];
+
+    param_table[0] = command;
+    param_table[1] = address;
+    param_table[2] = (uint32_t) (uintptr_t) data;
+    param_table[3] = size;
+    param_table[4] = SystemCoreClock / 1000;
+    iap_entry(param_table, result_table);
+
+    return result_table[0];
+}
+
+int hw_eeprom_read(uint32_t address, void *data, uint32_t size)
+{
+    return eeprom_command(62, address, data, size);
+}
+
+// the IAP call only returns when the data is programmed (about 3ms per EEPROM page)
+int hw_eeprom_write(uint32_t address, const void *data, uint32_t size)
+{
+    return eeprom_command(61, address, (void *) data, size);
+}
+
 inline int hw_self_test(void)
 {
     return g_self_test;
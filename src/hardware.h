@@ -22,6 +22,9 @@ enum {LED_R, LED_G, LED_B, LED_Y, LED_C, LED_M, LED_W};
 enum {LED_OFF, LED_ON, LED_TOGGLE = -1};
 enum {BUTTON_RELEASED, BUTTON_PRESSED};
 
+// places a variable in the 2K USB RAM (not used by the USB, its clock is enabled at reset)
+#define USB_RAM         __attribute__((section(".bss.$RamUsb2")))
+
 /*
 ****************************************************************************************************
 *       CONFIGURATION
@@ -46,6 +49,13 @@ enum {BUTTON_RELEASED, BUTTON_PRESSED};
 
 #define BUTTON_DEBOUNCE 10
 
+// pattern written by the startup code in the unused stack area
+#define STACK_PAINT     0xA5A5A5A5
+
+// EEPROM size available to the application (the last 64 bytes are reserved)
+#define EEPROM_SIZE     4032
+#define EEPROM_PAGE     64
+
 
 /*
 ****************************************************************************************************
@@ -62,10 +72,23 @@ enum {BUTTON_RELEASED, BUTTON_PRESSED};
 
 void hw_init(void);
 int hw_button(int button);
+int hw_button_state(int button);
+int hw_buttons_idle(void);
+uint32_t hw_button_time(int button);
 void hw_led(int led, int color, int value);
 uint32_t hw_uptime(void);
+uint32_t hw_time_us(void);
+uint32_t hw_cycles(void);
+uint32_t hw_cycles_per_ms(void);
+uint32_t hw_stack_free(void);
+uint32_t hw_stack_size(void);
+int hw_eeprom_read(uint32_t address, void *data, uint32_t size);
+int hw_eeprom_write(uint32_t address, const void *data, uint32_t size);
 int hw_self_test(void);
 void hw_led_set(int led, int color, int value, int on_time_ms, int off_time_ms);
+uint32_t hw_led_process(void);
+void hw_button_notify(void (*callback)(void));
+void hw_led_notify(void (*callback)(void));
 
 
 /*
@@ -0,0 +1,132 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "latency.h"
+#include "hardware.h"
+
+#ifdef LATENCY
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct measure_t {
+    uint32_t edge_us;
+    // next stage to be stamped, LAT_STAGES when there is no measure running
+    volatile uint8_t stage;
+} measure_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static measure_t g_measures[LATENCY_MAX_ACTUATORS] = {
+    [0 ... LATENCY_MAX_ACTUATORS - 1] = {.stage = LAT_STAGES}
+};
+static latency_stats_t g_stats[LAT_STAGES];
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void account(int stage, uint32_t latency_us)
+{
+    latency_stats_t *stats = &g_stats[stage];
+
+    int bucket = 0;
+    uint32_t limit = (1 << LATENCY_FIRST_BUCKET);
+    while (latency_us >= limit && bucket < (LATENCY_BUCKETS - 1))
+    {
+        limit <<= 1;
+        bucket++;
+    }
+
+    if (stats->histogram[bucket] < 0xFFFF)
+        stats->histogram[bucket]++;
+
+    stats->count++;
+    stats->total_us += latency_us;
+
+    if (latency_us > stats->max_us)
+        stats->max_us = latency_us;
+}
+
+static void stamp(measure_t *measure, int stage, uint32_t now_us)
+{
+    // stages are stamped in order, a stage can't be stamped twice
+    if (measure->stage != stage)
+        return;
+
+    account(stage, now_us - measure->edge_us);
+    measure->stage = stage + 1;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// called by the debouncer, starts a new measure
+void latency_edge(int actuator, uint32_t edge_us, uint32_t now_us)
+{
+    if (actuator >= LATENCY_MAX_ACTUATORS)
+        return;
+
+    measure_t *measure = &g_measures[actuator];
+    measure->edge_us = edge_us;
+    measure->stage = LAT_DEBOUNCE;
+    stamp(measure, LAT_DEBOUNCE, now_us);
+}
+
+// the actuators of every page share the measure of their switch, the gestures and the expression
+// pedal have none
+void latency_stage(int actuator, int stage)
+{
+    if (actuator >= ACTUATORS_COUNT)
+        return;
+
+    stamp(&g_measures[actuator % LATENCY_MAX_ACTUATORS], stage, hw_time_us());
+}
+
+// frames are not related to a single actuator, all the measures waiting for the stage are stamped
+void latency_frame(int stage)
+{
+    uint32_t now_us = hw_time_us();
+
+    for (int i = 0; i < LATENCY_MAX_ACTUATORS; i++)
+        stamp(&g_measures[i], stage, now_us);
+}
+
+const latency_stats_t *latency_stats(int stage)
+{
+    return &g_stats[stage];
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+#include "config.h"
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+// stages of a button event, measured from the first edge of the switch
+enum {
+    LAT_DEBOUNCE,   // debouncer confirmed the new state
+    LAT_PICKUP,     // buttons task read the event
+    LAT_WRITE,      // coalescer wrote the actuator value
+    LAT_ENQUEUE,    // frame handed to serial_send
+    LAT_WIRE,       // bus released after the last stop bit and the driver enable hold time
+    LAT_STAGES
+};
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// histogram buckets are powers of two: < 64us, < 128us, ..., the last one holds the overflow
+#define LATENCY_BUCKETS         12
+#define LATENCY_FIRST_BUCKET    6
+// one measure per switch, shared by the actuators of its pages
+#define LATENCY_MAX_ACTUATORS   FOOTSWITCHES_COUNT
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct latency_stats_t {
+    uint16_t histogram[LATENCY_BUCKETS];
+    uint32_t count, total_us, max_us;
+} latency_stats_t;
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+#ifdef LATENCY
+void latency_edge(int actuator, uint32_t edge_us, uint32_t now_us);
+void latency_stage(int actuator, int stage);
+void latency_frame(int stage);
+const latency_stats_t *latency_stats(int stage);
+#else
+#define latency_edge(actuator, edge_us, now_us) ((void) 0)
+#define latency_stage(actuator, stage) ((void) 0)
+#define latency_frame(stage) ((void) 0)
+#endif
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+
+#endif
@@ -4,6 +4,7 @@
 ****************************************************************************************************
 */
 
+#include "chip.h"
 #include "hardware.h"
 #include "serial.h"
 #include "clcd.h"
@@ -11,8 +12,20 @@
 #include "self_test.h"
 #include "config.h"
 #include "util.h"
+#include "coalescer.h"
+#include "trace.h"
+#include "sched.h"
+#include "latency.h"
+#include "prof.h"
+#include "store.h"
+#include "predict.h"
+#include "page.h"
+#include "gesture.h"
+#include "chord.h"
+#include "adc.h"
+#include "expression.h"
+#include "diag.h"
 #include <string.h>
-#include <math.h>
 
 /*
 ****************************************************************************************************
@@ -20,7 +33,24 @@
 ****************************************************************************************************
 */
 
-#define CLEAR_LINE          "                "
+#define N_BAUD_RATES        (sizeof(g_baud_rates)/sizeof(uint32_t))
+
+// tap tempo arithmetic, values cross the CC API as float
+#ifdef INTEGER_ONLY
+// thousandths of the unit
+#define TEMPO_SCALE         1000
+#define TEMPO(value)        tempo_from_value(value)
+// largest tempo, the running average of the taps adds up three of them
+#define TEMPO_MAX           (INT32_MAX / 3)
+#define TEMPO_VALUE_MAX     ((float) (TEMPO_MAX / TEMPO_SCALE))
+#define TEMPO_VALUE(tempo)  ((float) (tempo) * 0.001f)
+#define TEMPO_MS(ms)        ((uint32_t) (ms))
+#else
+#define TEMPO_SCALE         1
+#define TEMPO(value)        (value)
+#define TEMPO_VALUE(tempo)  (tempo)
+#define TEMPO_MS(ms)        ((uint32_t) ((ms) + 0.5))
+#endif
 
 /*
 ****************************************************************************************************
@@ -28,6 +58,13 @@
 ****************************************************************************************************
 */
 
+static const uint32_t g_baud_rates[] = SERIAL_BAUD_RATES;
+
+#ifdef LATENCY
+// latency stages, then the worst case of the path and the option predictions confirmed and rolled
+// back (latency chord only)
+static const char *g_latency_tags[LAT_STAGES + 3] = {"DB", "PK", "WR", "EQ", "TX", "MX", "PH", "PM"};
+#endif
 
 /*
 ****************************************************************************************************
@@ -37,8 +74,14 @@
 
 enum {TT_INIT, TT_COUNTING};
 
+#ifdef INTEGER_ONLY
+typedef int32_t tempo_t;
+#else
+typedef float tempo_t;
+#endif
+
 struct TAP_TEMPO_T {
-    uint32_t time, max;
+    uint32_t time, max; // time in us, max in ms
     uint8_t state;
 };
 
@@ -49,10 +92,34 @@ struct TAP_TEMPO_T {
 */
 
 static serial_t *g_serial;
-static float g_foot_value[FOOTSWITCHES_COUNT];
-static unsigned int g_welcome_timeout = 1000000;
-static struct TAP_TEMPO_T g_tap_tempo[FOOTSWITCHES_COUNT];
-static cc_assignment_t *g_current_assignment[FOOTSWITCHES_COUNT];
+static float g_foot_value[CC_MAX_ACTUATORS];
+static uint32_t g_welcome_timeout;
+static struct TAP_TEMPO_T g_tap_tempo[CC_MAX_ACTUATORS];
+static cc_assignment_t *g_current_assignment[CC_MAX_ACTUATORS];
+// actuator that got the press of each footswitch, the release goes to the same one
+static uint8_t g_pressed_actuator[FOOTSWITCHES_COUNT];
+static uint32_t g_pressed_time[FOOTSWITCHES_COUNT];
+static unsigned int g_baud_rate_index;
+// a frame was understood at the current baud rate, and when the last one was answered
+static volatile uint8_t g_baud_locked;
+static volatile uint32_t g_answer_time;
+#ifdef DIAG
+// a dump was asked by the chord, it waits for the master to be silent
+static uint8_t g_diag_pending;
+static volatile uint32_t g_receive_time;
+// parts of the dump: the one being built and the next to send
+static uint32_t g_diag_part, g_diag_next;
+static int g_task_diag;
+#endif
+#if defined(DIAG) || defined(LATENCY)
+// switches of a diagnostic chord, their presses and releases are not sent
+static uint8_t g_swallowed;
+#endif
+static int g_task_buttons, g_task_cc, g_task_leds, g_task_lcd, g_task_store, g_task_gestures;
+static volatile uint32_t g_lcd_dirty;
+static volatile uint8_t g_expression_update;
+static volatile uint32_t g_reconcile_timeout;
+static uint8_t g_provisional;
 
 /*
 ****************************************************************************************************
@@ -60,7 +127,98 @@ static cc_assignment_t *g_current_assignment[FOOTSWITCHES_COUNT];
 ****************************************************************************************************
 */
 
-static float convert_to_ms(const char *unit_from, float value)
+#ifdef INTEGER_ONLY
+// the cast of a float out of the range of tempo_t is undefined, the value is clamped before it
+static tempo_t tempo_from_value(float value)
+{
+    if (value >= TEMPO_VALUE_MAX)
+        return TEMPO_MAX;
+
+    if (value <= -TEMPO_VALUE_MAX)
+        return -TEMPO_MAX;
+
+    // NaN
+    if (value != value)
+        return 0;
+
+    return (tempo_t) (value * 1000.0f + 0.5f);
+}
+
+// takes thousandths of the unit, returns milliseconds
+static tempo_t convert_to_ms(const char *unit_from, tempo_t value)
+{
+    char unit[8];
+    uint8_t i;
+
+    // lower case unit string
+    for (i = 0; unit_from[i] && i < (sizeof(unit)-1); i++)
+    {
+        if (i == (sizeof(unit) - 1)) break;
+        unit[i] = unit_from[i] | 0x20;
+    }
+    unit[i] = 0;
+
+    if (value <= 0)
+        return 0;
+
+    if (strcmp(unit, "bpm") == 0)
+    {
+        return (60000000 / value);
+    }
+    else if (strcmp(unit, "hz") == 0)
+    {
+        return (1000000 / value);
+    }
+    else if (strcmp(unit, "s") == 0)
+    {
+        return value;
+    }
+    else if (strcmp(unit, "ms") == 0)
+    {
+        return (value / TEMPO_SCALE);
+    }
+
+    return 0;
+}
+
+// takes milliseconds, returns thousandths of the unit
+static tempo_t convert_from_ms(const char *unit_to, tempo_t value)
+{
+    char unit[8];
+    uint8_t i;
+
+    // lower case unit string
+    for (i = 0; unit_to[i] && i < (sizeof(unit)-1); i++)
+    {
+        if (i == (sizeof(unit) - 1)) break;
+        unit[i] = unit_to[i] | 0x20;
+    }
+    unit[i] = 0;
+
+    if (value <= 0)
+        return 0;
+
+    if (strcmp(unit, "bpm") == 0)
+    {
+        return (60000000 / value);
+    }
+    else if (strcmp(unit, "hz") == 0)
+    {
+        return (1000000 / value);
+    }
+    else if (strcmp(unit, "s") == 0)
+    {
+        return value;
+    }
+    else if (strcmp(unit, "ms") == 0)
+    {
+        return (value * TEMPO_SCALE);
+    }
+
+    return 0;
+}
+#else
+static tempo_t convert_to_ms(const char *unit_from, tempo_t value)
 {
     char unit[8];
     uint8_t i;
@@ -93,7 +251,7 @@ static float convert_to_ms(const char *unit_from, float value)
     return 0.0f;
 }
 
-static float convert_from_ms(const char *unit_to, float value)
+static tempo_t convert_from_ms(const char *unit_to, tempo_t value)
 {
     char unit[8];
     uint8_t i;
@@ -125,13 +283,13 @@ static float convert_from_ms(const char *unit_to, float value)
 
     return 0.0f;
 }
+#endif
 
-static void handle_tap_tempo(uint8_t actuator_id)
+static void handle_tap_tempo(uint8_t actuator_id, uint32_t time_us)
 {
-
-    uint32_t now = hw_uptime();
-    uint32_t delta = now - g_tap_tempo[actuator_id].time;
-    g_tap_tempo[actuator_id].time = now;
+    // use the time of the press itself, not the time the main loop picked it up
+    uint32_t delta = (time_us - g_tap_tempo[actuator_id].time) / 1000;
+    g_tap_tempo[actuator_id].time = time_us;
 
     cc_assignment_t *assignment = g_current_assignment[actuator_id];
 
@@ -147,13 +305,15 @@ static void handle_tap_tempo(uint8_t actuator_id)
     if (delta <= g_tap_tempo[actuator_id].max)
     {
         //get current value of tap tempo in ms
-        float currentTapVal = convert_to_ms(assignment->unit.text, assignment->value);
+        tempo_t value = TEMPO(assignment->value);
+        tempo_t currentTapVal = convert_to_ms(assignment->unit.text, value);
+        tempo_t distance = currentTapVal - (tempo_t) delta;
         //check if it should be added to running average
-        float tmp_tempo = 0;
-        if (fabs(currentTapVal - delta) < TAP_TEMPO_TAP_HYSTERESIS)
+        tempo_t tmp_tempo = 0;
+        if (distance < TAP_TEMPO_TAP_HYSTERESIS && distance > -TAP_TEMPO_TAP_HYSTERESIS)
         {
             // converts and update the tap tempo value
-            tmp_tempo = (2*(assignment->value) + convert_from_ms(assignment->unit.text, delta)) / 3;
+            tmp_tempo = (2*value + convert_from_ms(assignment->unit.text, delta)) / 3;
         }
         else
         {
@@ -162,29 +322,28 @@ static void handle_tap_tempo(uint8_t actuator_id)
         }
 
         // checks the values bounds
-        if (tmp_tempo > assignment->max) tmp_tempo = assignment->max;
-        else if (tmp_tempo < assignment->min) tmp_tempo = assignment->min;
+        if (tmp_tempo > TEMPO(assignment->max)) tmp_tempo = TEMPO(assignment->max);
+        else if (tmp_tempo < TEMPO(assignment->min)) tmp_tempo = TEMPO(assignment->min);
 
         //g_foot_value[g_current_page][actuator_id] = tmp_tempo;
-        g_foot_value[actuator_id] = tmp_tempo;
+        coalescer_push_timed(actuator_id, TEMPO_VALUE(tmp_tempo), COALESCER_LEVEL, time_us);
 
     }
 }
 
-static void waiting_message(int foot)
+// the line of an actuator without assignment shows its footswitch and page
+static void waiting_message(int actuator)
 {
-    char text[] = {"FOOT #X"};
-
-    // foot number
-    text[6] = '1' + foot;
+    char *line = page_line(actuator);
 
-    // define position to print
-    int lcd = (foot & 0x02) >> 1;
-    int line = foot & 0x01;
+    memset(line, ' ', PAGE_COLUMNS);
+    memcpy(line, "FOOT #", 6);
+    line[6] = '1' + PAGE_FOOT(actuator);
 
-    // print message
-    clcd_cursor_set(lcd, line, 0);
-    clcd_print(lcd, text);
+#if PAGES_COUNT > 1
+    line[PAGE_COLUMNS - 2] = 'P';
+    line[PAGE_COLUMNS - 1] = '1' + PAGE_OF(actuator);
+#endif
 }
 
 static void welcome_message(void)
@@ -208,9 +367,9 @@ static void welcome_message(void)
 
 static void turn_off_leds(void)
 {
-    for (int i = 0; i < FOOTSWITCHES_COUNT; i++)
+    for (int i = 0; i < ACTUATORS_COUNT; i++)
     {
-        hw_led_set(i, LED_W, LED_OFF, 0, 0);
+        page_led(i, PAGE_LED_OFF, 0, 0);
     }
 }
 
@@ -221,38 +380,61 @@ static void clear_all(void)
     // clear displays
     clcd_clear(0);
     clcd_clear(1);
+    page_cleared();
 
     // print waiting message for all footswitches
-    for (int i = 0; i < FOOTSWITCHES_COUNT; i++)
+    for (int i = 0; i < ACTUATORS_COUNT; i++)
         waiting_message(i);
+
+    // the displays were just cleared, the lines go at once
+    while (page_draw_next())
+        ;
 }
 
+// the LED state goes to the page cache, the LEDs change if the page is shown
 static void update_leds(cc_assignment_t *assignment)
 {
+    int actuator = assignment->actuator_id;
+
     if ((assignment->mode & CC_MODE_COLOURED) && (assignment->mode & CC_MODE_OPTIONS))
     {
-        hw_led_set(assignment->actuator_id, LED_R, LED_OFF, 0, 0);
-        hw_led_set(assignment->actuator_id, LED_G, LED_OFF, 0, 0);
-        hw_led_set(assignment->actuator_id, LED_B, LED_OFF, 0, 0);
-
-        const uint8_t color = (assignment->list_index % LED_COLOURS_AMOUNT);
-        hw_led_set(assignment->actuator_id, color, LED_ON, 0, 0);
+        const uint8_t color = (predict_index(actuator, assignment->list_index) % LED_COLOURS_AMOUNT);
+        page_led(actuator, color, 0, 0);
     }
     else if ((assignment->mode & CC_MODE_TRIGGER) || (assignment->mode & CC_MODE_OPTIONS))
-        hw_led_set(assignment->actuator_id, LED_G, LED_ON, 0, 0);
+        page_led(actuator, LED_G, 0, 0);
     else if (assignment->mode & CC_MODE_TOGGLE)
-        hw_led_set(assignment->actuator_id, LED_R, assignment->value ? LED_ON : LED_OFF,0,0);
+        page_led(actuator, predict_index(actuator, assignment->value != 0) ? LED_R : PAGE_LED_OFF, 0, 0);
     else if (assignment->mode & CC_MODE_TAP_TEMPO)
-        hw_led_set(assignment->actuator_id, LED_G, LED_ON, TAP_TEMPO_TIME_ON,(convert_to_ms(assignment->unit.text, assignment->value) - TAP_TEMPO_TIME_ON));
+        page_led(actuator, LED_G, TAP_TEMPO_TIME_ON,(convert_to_ms(assignment->unit.text, TEMPO(assignment->value)) - TAP_TEMPO_TIME_ON));
     else if (assignment->mode & CC_MODE_MOMENTARY)
-        hw_led_set(assignment->actuator_id, LED_R, assignment->value ? LED_ON : LED_OFF,0,0);
+        page_led(actuator, predict_index(actuator, assignment->value != 0) ? LED_R : PAGE_LED_OFF, 0, 0);
 }
 
-static void update_lcds(cc_assignment_t *assignment)
+// the host value confirms or corrects what the press of the switch showed
+static void confirm_prediction(cc_assignment_t *assignment)
 {
-    int lcd = (assignment->actuator_id & 0x02) >> 1;
-    int line = assignment->actuator_id & 0x01;
+    if (assignment->mode & CC_MODE_OPTIONS)
+        predict_confirm(assignment->actuator_id, assignment->list_index);
+    else if (assignment->mode & (CC_MODE_TOGGLE | CC_MODE_MOMENTARY))
+        predict_confirm(assignment->actuator_id, assignment->value != 0);
+}
 
+// restored assignments are shown until the host sends the current ones
+static void drop_provisional(void)
+{
+    for (int i = 0; i < ACTUATORS_COUNT; i++)
+    {
+        if (store_provisional(i))
+            g_current_assignment[i]->mode = 0;
+    }
+
+    g_provisional = 0;
+}
+
+// the line goes to the page cache, the lcd task draws it if the page is shown
+static void update_lcds(cc_assignment_t *assignment)
+{
     char buffer[17];
     uint8_t i;
 
@@ -270,10 +452,23 @@ static void update_lcds(cc_assignment_t *assignment)
         // separator
         buffer[i++] = ':';
 
-        // copy item label
-        str16_t *item_label = &assignment->list_items[assignment->list_index]->label;
-        for (int j = 0; j < item_label->size && i < sizeof(buffer); j++, i++)
-            buffer[i] = item_label->text[j];
+        // copy item label, the predicted one until the host answers
+        int list_index = predict_index(assignment->actuator_id, assignment->list_index);
+        const char *item_text;
+        uint8_t item_size;
+        if (store_provisional(assignment->actuator_id))
+        {
+            item_text = store_item_label(assignment->actuator_id, list_index, &item_size);
+        }
+        else
+        {
+            str16_t *item_label = &assignment->list_items[list_index]->label;
+            item_text = item_label->text;
+            item_size = item_label->size;
+        }
+
+        for (int j = 0; j < item_size && i < sizeof(buffer); j++, i++)
+            buffer[i] = item_text[j];
     }
     else if (assignment->mode & CC_MODE_TAP_TEMPO)
     {
@@ -287,7 +482,11 @@ static void update_lcds(cc_assignment_t *assignment)
         {
             // copy value to label
             char value_label[6];
+#ifdef INTEGER_ONLY
+            uint8_t value_size = milli_to_str(TEMPO(assignment->value), value_label, sizeof(value_label),2);
+#else
             uint8_t value_size = float_to_str(assignment->value, value_label, sizeof(value_label),2);
+#endif
             for (int j = 0; j < value_size && i < sizeof(buffer); j++, i++)
                 buffer[i] = value_label[j];
         }
@@ -296,7 +495,7 @@ static void update_lcds(cc_assignment_t *assignment)
         {
             // copy value to label
             char value_label[6];
-            uint8_t value_size = int_to_str(assignment->value, value_label, sizeof(value_label),0,0);
+            uint8_t value_size = int_to_str(TEMPO(assignment->value) / TEMPO_SCALE, value_label, sizeof(value_label),0,0);
             for (int j = 0; j < value_size && i < sizeof(buffer); j++, i++)
                 buffer[i] = value_label[j];
         }
@@ -312,24 +511,243 @@ static void update_lcds(cc_assignment_t *assignment)
     buffer[sizeof(buffer) - 1] = 0;
 
     // print buffer to lcd
-    clcd_cursor_set(lcd, line, 0);
-    clcd_print(lcd, buffer);
+    memcpy(page_line(assignment->actuator_id), buffer, PAGE_COLUMNS);
+}
+
+// the lcd line is redrawn by the lcd task
+static void lcd_refresh(int actuator_id)
+{
+    // the gestures have no display line
+    if (actuator_id >= ACTUATORS_COUNT)
+        return;
+
+    g_lcd_dirty |= (1UL << actuator_id);
+    sched_event(g_task_lcd, SCHED_EV_WAKEUP);
+}
+
+// the store writes the assignments once they settle
+static void assignments_changed(void)
+{
+    store_changed();
+    sched_event(g_task_store, SCHED_EV_WAKEUP);
 }
 
 static void serial_recv(void *arg)
 {
     cc_data_t *data = arg;
 
-    // use regular baud rate option if parse failed many times
-    if (cc_parse(data) < 0)
-        serial_baud_rate_set(CC_BAUD_RATE);
+    // step to the next baud rate if parse failed many times, unless a frame was already understood
+    // at this rate: noise on a working link doesn't move it
+    if (cc_parse(data) < 0 && !g_baud_locked)
+    {
+        for (unsigned int i = 0; i < N_BAUD_RATES; i++)
+        {
+            g_baud_rate_index = (g_baud_rate_index + 1) % N_BAUD_RATES;
+
+            if (serial_baud_rate_set(g_baud_rates[g_baud_rate_index]))
+                break;
+        }
+    }
+    // the host is talking, it has some time to send the assignments again
+    else if (g_provisional && g_reconcile_timeout == 0)
+    {
+        g_reconcile_timeout = hw_uptime() + STORE_RECONCILE_TIMEOUT;
+    }
+
+#ifdef DIAG
+    g_receive_time = hw_uptime();
+#endif
+
+    sched_event(g_task_cc, SCHED_EV_WAKEUP);
 }
 
 static void response_cb(void *arg)
 {
     serial_data_t *data = arg;
     serial_send(g_serial, data);
+
+    // the library only answers frames it could parse, the master and the device agree on the rate
+    g_answer_time = hw_uptime();
+    g_baud_locked = 1;
+
+    // pending updates can go in the next frame
+    coalescer_flushed();
+}
+
+#if defined(DIAG) || defined(LATENCY)
+// the press of foot makes a chord with the other switch of its pair when that one is held and was
+// pressed within the chord window (src/chord.h), a switch held for long doesn't make one
+static int pair_chord(int foot)
+{
+    int other = foot ^ 1;
+    return hw_button_state(other) &&
+        (uint32_t) (g_pressed_time[foot] - g_pressed_time[other]) < (CHORD_WINDOW * 1000);
+}
+#endif
+
+#ifdef DIAG
+// the dump is cut in parts of DIAG_PART_SIZE bytes, the ones before g_diag_next went out in
+// earlier runs of the diag task and the next ones wait for the driver to take the last one sent
+static void diag_write(const uint8_t *data, uint32_t size)
+{
+    for (uint32_t offset = 0; offset < size; offset += DIAG_PART_SIZE, g_diag_part++)
+    {
+        if (g_diag_part != g_diag_next || serial_tx_pending(g_serial))
+            continue;
+
+        serial_data_t sdata;
+        sdata.data = (uint8_t *) &data[offset];
+        sdata.size = (size - offset < DIAG_PART_SIZE ? size - offset : DIAG_PART_SIZE);
+        serial_send(g_serial, &sdata);
+
+        g_diag_next++;
+    }
+}
+
+// sends the wire trace, the profiler data and the counters through the serial
+static void diag_dump(void)
+{
+#ifdef TRACE
+    trace_dump(diag_write);
+#endif
+#ifdef PROFILE
+    prof_dump(diag_write);
+#endif
+
+    diag_begin(diag_write);
+    diag_counter("merged", coalescer_merged());
+    diag_counter("refused", coalescer_refused());
+    diag_counter("tx_frame", serial_stats()->frames);
+    diag_counter("tx_drop", serial_stats()->dropped);
+    diag_counter("exp_smp", expression_stats()->samples);
+    diag_counter("exp_upd", expression_stats()->updates);
+
+    sched_stats_t stats;
+    for (int i = 0; sched_stats(i, &stats) == 0; i++)
+    {
+        diag_counter_of(stats.name, "run", stats.runs);
+        diag_counter_of(stats.name, "mis", stats.deadline_misses);
+        diag_counter_of(stats.name, "ovr", stats.overruns);
+        diag_counter_of(stats.name, "lat", stats.latency_max_us);
+        diag_counter_of(stats.name, "exe", stats.runtime_max_us);
+    }
+
+    // time the cpu slept out of the time since the scheduler started
+    sched_idle_stats_t idle;
+    sched_idle_stats(&idle);
+    diag_counter("sleeps", idle.sleeps);
+    diag_counter("idle_ms", (uint32_t) (idle.idle_us / 1000));
+    diag_counter("sched_ms", (uint32_t) (idle.elapsed_us / 1000));
+    diag_counter("wakes", idle.wakes);
+    diag_counter("wake_max_us", idle.wake_max_us);
+    diag_counter("wake_mean_us", (uint32_t) (idle.wakes ? idle.wake_total_us / idle.wakes : 0));
+
+    // stack never reached since the reset, out of its size (in bytes)
+    diag_counter("stk_free", hw_stack_free());
+    diag_counter("stk_size", hw_stack_size());
+
+#ifdef LATENCY
+    // histogram bucket n counts the latencies under 2^(LATENCY_FIRST_BUCKET + n) us
+    for (int stage = 0; stage < LAT_STAGES; stage++)
+    {
+        const latency_stats_t *stats = latency_stats(stage);
+        diag_counter_of(g_latency_tags[stage], "cnt", stats->count);
+        diag_counter_of(g_latency_tags[stage], "sum", stats->total_us);
+        diag_counter_of(g_latency_tags[stage], "max", stats->max_us);
+
+        for (int i = 0; i < LATENCY_BUCKETS; i++)
+        {
+            char bucket[4] = {'h'};
+            int_to_str(i, &bucket[1], sizeof(bucket) - 1, 0, 0);
+            diag_counter_of(g_latency_tags[stage], bucket, stats->histogram[i]);
+        }
+    }
+#endif
+
+    diag_end();
+}
+
+// foot 1 + foot 2 freezes the wire trace and asks for the dump, which is sent once the master is
+// silent (stopped or unplugged) so it doesn't collide with the bus traffic
+static int diag_chord(int foot)
+{
+    if (foot > 1 || !pair_chord(foot))
+        return 0;
+
+    trace_freeze();
+    g_diag_pending = 1;
+
+    clcd_cursor_set(0, CLCD_LINE1, 0);
+    clcd_print(0, "DIAG WAITS BUS  ");
+    page_invalidate();
+
+    return 1;
+}
+#endif
+
+#ifdef LATENCY
+// foot 3 + foot 4 shows the average latency of each stage (in us) measured from the switch edge,
+// the worst case of the whole path and the option predictions confirmed and rolled back
+static int latency_chord(int foot)
+{
+    if (foot < 2 || !pair_chord(foot))
+        return 0;
+
+    const predict_stats_t *predict = predict_stats();
+    char line[17];
+    int lcd = 0, row = 0, col = 0;
+
+    for (int field = 0; field < LAT_STAGES + 3; field++)
+    {
+        uint32_t value;
+        if (field < LAT_STAGES)
+        {
+            const latency_stats_t *stats = latency_stats(field);
+            value = (stats->count ? stats->total_us / stats->count : 0);
+        }
+        else if (field == LAT_STAGES)
+        {
+            value = latency_stats(LAT_WIRE)->max_us;
+        }
+        else if (field == LAT_STAGES + 1)
+        {
+            value = predict->hits;
+        }
+        else
+        {
+            value = predict->mismatches + predict->timeouts;
+        }
+
+        const char *tag = g_latency_tags[field];
+        line[col++] = tag[0];
+        line[col++] = tag[1];
+
+        char number[8];
+        uint32_t size = int_to_str(value > 999999 ? 999999 : value, number, sizeof(number), 0, 0);
+        for (uint32_t i = size; i < 6; i++)
+            line[col++] = ' ';
+        for (uint32_t i = 0; i < size; i++)
+            line[col++] = number[i];
+
+        if (col == 16)
+        {
+            line[col] = 0;
+            clcd_cursor_set(lcd, row, 0);
+            clcd_print(lcd, line);
+
+            col = 0;
+            if (++row == 2)
+            {
+                row = 0;
+                lcd++;
+            }
+        }
+    }
+
+    page_invalidate();
+    return 1;
 }
+#endif
 
 static void events_cb(void *arg)
 {
@@ -367,6 +785,7 @@ static void events_cb(void *arg)
 
         cc_assignment_t *assignment = event->data;
         g_current_assignment[assignment->actuator_id] = assignment;
+        predict_cancel(assignment->actuator_id);
 
         if (assignment->mode & CC_MODE_TAP_TEMPO)
         {
@@ -378,7 +797,7 @@ static void events_cb(void *arg)
                 // time unit (ms, s)
                 if (strcmp(assignment->unit.text, "ms") == 0 || strcmp(assignment->unit.text, "s") == 0)
                 {
-                    max = (uint32_t)(convert_to_ms(assignment->unit.text, assignment->max) + 0.5);
+                    max = TEMPO_MS(convert_to_ms(assignment->unit.text, TEMPO(assignment->max)));
                     //makes sure we enforce a proper timeout
                     if (max > TAP_TEMPO_DEFAULT_TIMEOUT)
                         max = TAP_TEMPO_DEFAULT_TIMEOUT;
@@ -390,7 +809,7 @@ static void events_cb(void *arg)
                     if (assignment->min == 0)
                         max = TAP_TEMPO_DEFAULT_TIMEOUT;
                     else
-                        max = (uint32_t)(convert_to_ms(assignment->unit.text, assignment->min) + 0.5);
+                        max = TEMPO_MS(convert_to_ms(assignment->unit.text, TEMPO(assignment->min)));
 
                     //makes sure we enforce a proper timeout
                     if (max > TAP_TEMPO_DEFAULT_TIMEOUT)
@@ -404,25 +823,21 @@ static void events_cb(void *arg)
         }
 
         update_leds(assignment);
-        update_lcds(assignment);
+        lcd_refresh(assignment->actuator_id);
+        assignments_changed();
     }
 
     else if (event->id == CC_EV_UNASSIGNMENT)
     {
         int *act_id = event->data;
         int actuator_id = *act_id;
+        predict_cancel(actuator_id);
 
-        int lcd = (actuator_id & 0x02) >> 1;
-        int line = actuator_id & 0x01;
-
-        // clear lcd line
-        clcd_cursor_set(lcd, line, 0);
-        clcd_print(lcd, CLEAR_LINE);
-
-        waiting_message(actuator_id);
+        // lcd task shows the waiting message
+        lcd_refresh(actuator_id);
 
         // turn off leds
-        hw_led_set(actuator_id, LED_W, LED_OFF, 0, 0);
+        page_led(actuator_id, PAGE_LED_OFF, 0, 0);
 
         //properly clear all values
         g_tap_tempo[actuator_id].time = 0;
@@ -431,13 +846,16 @@ static void events_cb(void *arg)
 
         //clear assignment mode
         g_current_assignment[actuator_id]->mode = 0;
+        assignments_changed();
     }
 
     else if (event->id == CC_EV_UPDATE)
     {
         cc_assignment_t *assignment = event->data;
+        confirm_prediction(assignment);
         update_leds(assignment);
-        update_lcds(assignment);
+        lcd_refresh(assignment->actuator_id);
+        assignments_changed();
     }
 
     else if (event->id == CC_CMD_SET_VALUE)
@@ -449,16 +867,444 @@ static void events_cb(void *arg)
             assignment->list_index = set_value->value;
 
         assignment->value = set_value->value;
+        confirm_prediction(assignment);
         update_leds(assignment);
-        update_lcds(assignment);
+        lcd_refresh(assignment->actuator_id);
+        assignments_changed();
     }
 
     else if (event->id == CC_EV_MASTER_RESETED)
     {
+        // the restored assignments go away along with the displayed ones
+        drop_provisional();
         clear_all();
     }
 }
 
+// the chord shows the next page, the pre-rendered LEDs right away and the lines by the lcd task
+static void page_next(void)
+{
+    page_select((page_current() + 1) % PAGES_COUNT);
+    sched_event(g_task_lcd, SCHED_EV_WAKEUP);
+}
+
+// the double tap and the repeats are pulses, the long press lasts until the release
+static void send_gestures(int foot, int gestures, int held)
+{
+    for (int gesture = 0; gesture < GESTURES_COUNT; gesture++)
+    {
+        if ((gestures & (1 << gesture)) == 0)
+            continue;
+
+        int actuator = GESTURE_ACTUATOR(gesture, foot);
+        if (gesture == GESTURE_LONG)
+        {
+            coalescer_push(actuator, held ? 1.0 : 0.0, COALESCER_EDGE);
+        }
+        else
+        {
+            coalescer_push(actuator, 1.0, COALESCER_EDGE);
+            coalescer_push(actuator, 0.0, COALESCER_EDGE);
+        }
+    }
+}
+
+static void foot_pressed(int foot, uint32_t button_time)
+{
+    int actuator = g_pressed_actuator[foot];
+
+    // the switches also work before the first assignment
+    cc_assignment_t *assignment = g_current_assignment[actuator];
+    uint32_t mode = (assignment ? assignment->mode : 0);
+
+    if (mode & (CC_MODE_TRIGGER | CC_MODE_OPTIONS) && !(mode & CC_MODE_COLOURED))
+    {
+        //update leds, through the page of the actuator as the page may change before the release
+        page_led(actuator, LED_W, 0, 0);
+    }
+    if (g_tap_tempo[actuator].state == TT_COUNTING)
+    {
+        //handle tap tempo
+        handle_tap_tempo(actuator, button_time);
+    }
+    else
+    {
+        coalescer_push_timed(actuator, 1.0, COALESCER_EDGE, button_time);
+    }
+
+    // the next option is shown right away, the host answer confirms or rolls it back
+    if ((mode & CC_MODE_OPTIONS) && assignment->list_count > 0)
+    {
+        predict_press(actuator, assignment->list_index, assignment->list_count, hw_uptime());
+
+        if (mode & CC_MODE_COLOURED)
+            update_leds(assignment);
+
+        lcd_refresh(actuator);
+    }
+    // the red LED follows the switch in the same way
+    else if (mode & (CC_MODE_TOGGLE | CC_MODE_MOMENTARY))
+    {
+        if (mode & CC_MODE_TOGGLE)
+            predict_press(actuator, assignment->value != 0, 2, hw_uptime());
+        else
+            predict_set(actuator, 1, hw_uptime());
+
+        update_leds(assignment);
+    }
+
+    // the press is already sent, a double tap comes in addition to it
+    send_gestures(foot, gesture_edge(foot, 1, button_time), 1);
+
+    // the gestures task times the long press of the held switch
+    sched_event(g_task_gestures, SCHED_EV_WAKEUP);
+}
+
+static void foot_released(int foot, uint32_t button_time)
+{
+    int actuator = g_pressed_actuator[foot];
+    cc_assignment_t *assignment = g_current_assignment[actuator];
+    uint32_t mode = (assignment ? assignment->mode : 0);
+
+    if (mode & (CC_MODE_TRIGGER | CC_MODE_OPTIONS) && !(mode & CC_MODE_COLOURED))
+    {
+        //update leds
+        page_led(actuator, LED_G, 0, 0);
+    }
+    if (g_tap_tempo[actuator].state != TT_COUNTING)
+    {
+       coalescer_push_timed(actuator, 0.0, COALESCER_EDGE, button_time);
+    }
+    if (mode & CC_MODE_MOMENTARY)
+    {
+        predict_set(actuator, 0, hw_uptime());
+        update_leds(assignment);
+    }
+
+    send_gestures(foot, gesture_edge(foot, 0, button_time), 0);
+}
+
+// the press of a chord switch waits for the other one when the assignment can't take it back
+static int chord_defer(int actuator)
+{
+    cc_assignment_t *assignment = g_current_assignment[actuator];
+    return (assignment && (assignment->mode & CHORD_DEFER_MODES));
+}
+
+#if defined(DIAG) || defined(LATENCY)
+// the presses of a diagnostic chord are not sent, the first one is taken back if it already was
+static void chord_swallow(int foot, int other, uint32_t button_time)
+{
+    if (chord_cancel(other))
+    {
+        foot_released(other, button_time);
+        gesture_cancel(other);
+    }
+
+    g_swallowed |= (1 << foot) | (1 << other);
+}
+#endif
+
+static void buttons_task(uint32_t events)
+{
+    (void) events;
+
+    for (int i = 0; i < FOOTSWITCHES_COUNT; i++)
+    {
+        int button_status = hw_button(i);
+        uint32_t button_time = hw_button_time(i);
+
+        if (button_status >= 0)
+            latency_stage(i, LAT_PICKUP);
+
+        if (button_status == BUTTON_PRESSED)
+        {
+            // the press and its release go to the actuator of the page shown at the press
+            g_pressed_actuator[i] = (page_current() * FOOTSWITCHES_COUNT) + i;
+            g_pressed_time[i] = button_time;
+
+#if defined(DIAG) || defined(LATENCY)
+            int diag = 0;
+#ifdef DIAG
+            diag |= diag_chord(i);
+#endif
+#ifdef LATENCY
+            diag |= latency_chord(i);
+#endif
+            if (diag)
+            {
+                chord_swallow(i, i ^ 1, button_time);
+                continue;
+            }
+#endif
+            int other = chord_other(i);
+
+            switch (chord_press(i, chord_defer(g_pressed_actuator[i]), hw_time_us()))
+            {
+                case CHORD_SEND:
+                    foot_pressed(i, button_time);
+                    break;
+
+                case CHORD_RETRACT:
+                    // the press sent by the other switch is taken back by its release
+                    foot_released(other, button_time);
+                    // fall through
+                case CHORD_COMPLETE:
+                    page_next();
+                    gesture_cancel(other);
+                    break;
+            }
+        }
+
+        else if (button_status == BUTTON_RELEASED)
+        {
+            int chord = chord_release(i, hw_time_us());
+
+#if defined(DIAG) || defined(LATENCY)
+            if (g_swallowed & (1 << i))
+            {
+                g_swallowed &= ~(1 << i);
+                continue;
+            }
+#endif
+
+            // the releases of a chord are not sent
+            if (chord == CHORD_COMPLETE)
+                continue;
+
+            if (chord == CHORD_WAIT)
+                foot_pressed(i, g_pressed_time[i]);
+
+            foot_released(i, button_time);
+        }
+    }
+
+    // new values go to the next update frame
+    sched_event(g_task_cc, SCHED_EV_WAKEUP);
+}
+
+// long presses and repeats of the held switches, polled when the next one is due
+static void gestures_task(uint32_t events)
+{
+    (void) events;
+
+    uint32_t now = hw_time_us();
+    uint32_t next_us = 0;
+    int gestures = 0;
+
+    for (int i = 0; i < FOOTSWITCHES_COUNT; i++)
+    {
+        int foot_gestures = gesture_poll(i, now);
+        send_gestures(i, foot_gestures, 1);
+        gestures |= foot_gestures;
+
+        uint32_t foot_next_us = gesture_next(i, now);
+        if (foot_next_us && (!next_us || foot_next_us < next_us))
+            next_us = foot_next_us;
+    }
+
+    if (gestures)
+        sched_event(g_task_cc, SCHED_EV_WAKEUP);
+
+    // the wakeup counts whole milliseconds of the uptime, the first one at or after the gesture
+    if (next_us)
+        sched_wakeup(g_task_gestures, ((now % 1000) + next_us + 999) / 1000);
+}
+
+#ifdef DIAG
+// sends the parts of the dump the driver can take, the other tasks run while it empties
+static void diag_task(uint32_t events)
+{
+    (void) events;
+
+    // the dump is built again up to the next part, the trace is frozen and the counters are the
+    // same ones
+    g_diag_part = 0;
+    diag_dump();
+
+    // the rest waits for the driver to take what was sent
+    if (g_diag_part > g_diag_next)
+    {
+        sched_wakeup(g_task_diag, 1);
+        return;
+    }
+
+    clcd_cursor_set(0, CLCD_LINE1, 0);
+    clcd_print(0, "DIAG SENT       ");
+    page_invalidate();
+}
+#endif
+
+static void cc_task(uint32_t events)
+{
+    (void) events;
+
+    // the pedal position goes with the other values, a newer one replaces it while it waits
+    if (g_expression_update)
+    {
+        g_expression_update = 0;
+        coalescer_push(EXPRESSION_ACTUATOR, expression_value() / (float) EXPRESSION_MAX, COALESCER_LEVEL);
+    }
+
+    // presses that waited for a chord that didn't come
+    uint32_t due = chord_due(hw_time_us());
+    for (int i = 0; i < FOOTSWITCHES_COUNT; i++)
+    {
+        if (due & (1 << i))
+            foot_pressed(i, g_pressed_time[i]);
+    }
+
+    // latest values of all actuators go together in the next update frame
+    coalescer_commit();
+
+    PROF_ENTER(PROF_CC_PROCESS);
+    cc_process();
+    PROF_EXIT(PROF_CC_PROCESS);
+}
+
+static void lcd_task(uint32_t events)
+{
+    (void) events;
+
+    __disable_irq();
+    uint32_t dirty = g_lcd_dirty;
+    g_lcd_dirty = 0;
+    __enable_irq();
+
+    // the lines of all pages are rendered, only the shown ones are drawn
+    for (int i = 0; i < ACTUATORS_COUNT; i++)
+    {
+        if ((dirty & (1UL << i)) == 0)
+            continue;
+
+        cc_assignment_t *assignment = g_current_assignment[i];
+        if (assignment && assignment->mode)
+        {
+            update_lcds(assignment);
+        }
+        else
+        {
+            waiting_message(i);
+        }
+    }
+
+    // lines of a page just selected or written over by something else, one per run so the
+    // switches are read between the lines
+    if (page_draw_next())
+        sched_event(g_task_lcd, SCHED_EV_WAKEUP);
+}
+
+// the blinking LEDs, woken when one starts to blink and then at each change
+static void leds_task(uint32_t events)
+{
+    (void) events;
+
+    uint32_t next = hw_led_process();
+    if (next)
+        sched_wakeup(g_task_leds, next);
+}
+
+static void timeouts_task(uint32_t events)
+{
+    (void) events;
+
+    // predicted options the host didn't answer go back to the current ones
+    uint32_t expired = predict_expire(hw_uptime());
+    for (int i = 0; i < ACTUATORS_COUNT; i++)
+    {
+        if ((expired & (1UL << i)) && g_current_assignment[i])
+        {
+            update_leds(g_current_assignment[i]);
+            lcd_refresh(i);
+        }
+    }
+
+    // the master is gone, the next one may come at another rate
+    __disable_irq();
+    if (g_baud_locked && (hw_uptime() - g_answer_time) >= SERIAL_BAUD_LOCK_TIMEOUT)
+        g_baud_locked = 0;
+    __enable_irq();
+
+#ifdef DIAG
+    // the dump has the bus for itself
+    if (g_diag_pending && (hw_uptime() - g_receive_time) >= DIAG_QUIET_TIME)
+    {
+        g_diag_pending = 0;
+        g_diag_next = 0;
+        sched_event(g_task_diag, SCHED_EV_WAKEUP);
+    }
+#endif
+
+    if (g_welcome_timeout > 0 && (int32_t) (hw_uptime() - g_welcome_timeout) >= 0)
+    {
+        g_welcome_timeout = 0;
+        clear_all();
+    }
+
+    // restored assignments the host didn't send again are dropped
+    if (g_reconcile_timeout > 0 && (int32_t) (hw_uptime() - g_reconcile_timeout) >= 0)
+    {
+        g_reconcile_timeout = 0;
+
+        for (int i = 0; i < ACTUATORS_COUNT; i++)
+        {
+            if (store_provisional(i))
+            {
+                page_led(i, PAGE_LED_OFF, 0, 0);
+                lcd_refresh(i);
+                assignments_changed();
+            }
+        }
+
+        drop_provisional();
+    }
+}
+
+// woken by the changes, then when the record is due and between its pages
+static void store_task(uint32_t events)
+{
+    (void) events;
+
+    // an EEPROM page holds the main loop for about 3 ms, it waits for the switches and the bus to
+    // be quiet so no button event or frame is held up, a held switch is checked again at each
+    // debounce time
+    if (!hw_buttons_idle())
+    {
+        sched_wakeup(g_task_store, BUTTON_DEBOUNCE);
+        return;
+    }
+
+    if (serial_receiving(g_serial))
+    {
+        sched_wakeup(g_task_store, 1);
+        return;
+    }
+
+    uint32_t next = store_process();
+    if (next)
+        sched_wakeup(g_task_store, next);
+}
+
+static void button_event(void)
+{
+    sched_event(g_task_buttons, SCHED_EV_WAKEUP);
+}
+
+static void led_blink(void)
+{
+    sched_event(g_task_leds, SCHED_EV_WAKEUP);
+}
+
+// the filter runs at each burst, only the samples that move the pedal wake the cc task
+static void adc_sample(uint32_t sum)
+{
+    if (expression_sample(sum))
+    {
+        g_expression_update = 1;
+        sched_event(g_task_cc, SCHED_EV_WAKEUP);
+    }
+}
+
 /*
 ****************************************************************************************************
 *       GLOBAL FUNCTIONS
@@ -468,7 +1314,9 @@ static void events_cb(void *arg)
 int main(void)
 {
     hw_init();
+    page_init();
     welcome_message();
+    g_welcome_timeout = hw_uptime() + WELCOME_TIMEOUT;
 
     // execute self-test if required
     // the device never leaves the self-test routine
@@ -477,87 +1325,130 @@ int main(void)
         self_test_run();
     }
 
-    for (uint8_t j = 0; j < (FOOTSWITCHES_COUNT); j++)
+    for (uint8_t j = 0; j < (CC_MAX_ACTUATORS); j++)
     {
         g_tap_tempo[j].state = TT_INIT;
     }
 
+    for (int i = 0; i < FOOTSWITCHES_COUNT; i++)
+        g_pressed_actuator[i] = i;
+
+    // the edge times are written by the coalescer along with the values of the pages
+    coalescer_init(g_foot_value, EDGE_TIME_ACTUATOR(0));
+    for (int i = 0; i < ACTUATORS_COUNT; i++)
+        coalescer_time_actuator(i, EDGE_TIME_ACTUATOR(PAGE_FOOT(i)));
+
     cc_init(response_cb, events_cb);
     cc_device_t *device = cc_device_new("FootEx", "https://github.com/moddevices/cc-fw-footswitch");
 
-    // create actuators
-    for (int i = 0; i < FOOTSWITCHES_COUNT; i++)
+    // create actuators, one per footswitch of each page, one per gesture of each footswitch, the
+    // expression pedal and the edge time of each footswitch
+    static const char *gesture_names[GESTURES_COUNT] = {" Long", " Double", " Repeat"};
+    for (int i = 0; i < CC_MAX_ACTUATORS; i++)
     {
         char name[16] = {"Foot #"};
-        name[6] = '1' + i;
+        name[6] = '1' + PAGE_FOOT(i);
         name[7] = 0;
 
         cc_actuator_config_t actuator_config;
         actuator_config.type = CC_ACTUATOR_MOMENTARY;
+        actuator_config.supported_modes = CC_MODE_TOGGLE | CC_MODE_TRIGGER | CC_MODE_OPTIONS | CC_MODE_TAP_TEMPO | CC_MODE_COLOURED | CC_MODE_MOMENTARY;
+
+        if (i == EXPRESSION_ACTUATOR)
+        {
+            strcpy(name, "Expression");
+            actuator_config.type = CC_ACTUATOR_CONTINUOUS;
+            actuator_config.supported_modes = CC_MODE_REAL | CC_MODE_INTEGER | CC_MODE_LOGARITHMIC;
+        }
+        // microseconds, the host takes them from the arrival time of the frame to get the edge
+        else if (i >= EDGE_TIME_ACTUATOR(0))
+        {
+            name[6] = '1' + (i - EDGE_TIME_ACTUATOR(0));
+            strcpy(&name[7], " Time");
+            actuator_config.type = CC_ACTUATOR_CONTINUOUS;
+            actuator_config.supported_modes = CC_MODE_REAL | CC_MODE_INTEGER;
+        }
+        // the gestures have no display line nor LED to show options or a tempo
+        else if (i >= ACTUATORS_COUNT)
+        {
+            strcpy(&name[7], gesture_names[(i - ACTUATORS_COUNT) / FOOTSWITCHES_COUNT]);
+            actuator_config.supported_modes = CC_MODE_TOGGLE | CC_MODE_TRIGGER | CC_MODE_MOMENTARY;
+        }
+        else if (PAGE_OF(i) > 0)
+        {
+            name[7] = ' ';
+            name[8] = 'P';
+            name[9] = '1' + PAGE_OF(i);
+            name[10] = 0;
+        }
+
         actuator_config.name = name;
         actuator_config.value = &g_foot_value[i];
         actuator_config.min = 0.0;
-        actuator_config.max = 1.0;
-        actuator_config.supported_modes = CC_MODE_TOGGLE | CC_MODE_TRIGGER | CC_MODE_OPTIONS | CC_MODE_TAP_TEMPO | CC_MODE_COLOURED | CC_MODE_MOMENTARY;
+        actuator_config.max = (i >= EDGE_TIME_ACTUATOR(0) ? EDGE_TIME_MAX : 1.0);
         actuator_config.max_assignments = 1;
 
         cc_actuator_t *actuator = cc_actuator_new(&actuator_config);
         cc_device_actuator_add(device, actuator);
     }
 
-    // init serial
-    g_serial = serial_init(CC_BAUD_RATE_FALLBACK, serial_recv);
+    // create tasks, lower priority value runs first
+    static const sched_task_config_t tasks[] = {
+        {.name = "buttons", .run = buttons_task, .priority = 0, .period_ms = 0, .deadline_us = 1000},
+        {.name = "cc", .run = cc_task, .priority = 1, .period_ms = 1, .deadline_us = 2000},
+        {.name = "leds", .run = leds_task, .priority = 2, .period_ms = 0, .deadline_us = 2000},
+        {.name = "lcd", .run = lcd_task, .priority = 3, .period_ms = 0, .deadline_us = 20000},
+        {.name = "timeouts", .run = timeouts_task, .priority = 4, .period_ms = 100, .deadline_us = 0},
+        {.name = "store", .run = store_task, .priority = 5, .period_ms = 0, .deadline_us = 0},
+        {.name = "gestures", .run = gestures_task, .priority = 6, .period_ms = 0, .deadline_us = 0},
+#ifdef DIAG
+        {.name = "diag", .run = diag_task, .priority = 7, .period_ms = 0, .deadline_us = 0},
+#endif
+    };
+
+    g_task_buttons = sched_task_add(&tasks[0]);
+    g_task_cc = sched_task_add(&tasks[1]);
+    g_task_leds = sched_task_add(&tasks[2]);
+    g_task_lcd = sched_task_add(&tasks[3]);
+    sched_task_add(&tasks[4]);
+    g_task_store = sched_task_add(&tasks[5]);
+    g_task_gestures = sched_task_add(&tasks[6]);
+#ifdef DIAG
+    g_task_diag = sched_task_add(&tasks[7]);
+#endif
 
+    // the restored LEDs may blink
+    hw_led_notify(led_blink);
 
-    while (1)
+    // show the assignments of the last session until the host sends the current ones
+    store_init(g_current_assignment, ACTUATORS_COUNT);
+    if (store_restore() > 0)
     {
-        if (g_welcome_timeout > 0)
-        {
-            if (--g_welcome_timeout == 0)
-                clear_all();
-        }
+        g_welcome_timeout = 0;
+        g_provisional = 1;
+        clear_all();
 
-        for (int i = 0; i < FOOTSWITCHES_COUNT; i++)
+        for (int i = 0; i < ACTUATORS_COUNT; i++)
         {
-            int button_status = hw_button(i);
-
-            if (button_status == BUTTON_PRESSED)
+            if (store_provisional(i))
             {
-                if (g_current_assignment[i]->mode & (CC_MODE_TRIGGER | CC_MODE_OPTIONS) && !(g_current_assignment[i]->mode & CC_MODE_COLOURED))
-                {
-                    //update leds
-                    hw_led_set(i, LED_G, LED_OFF,0,0);
-                    hw_led_set(i, LED_W, LED_ON,0,0);
-                }
-                if (g_tap_tempo[i].state == TT_COUNTING)
-                {
-                    //handle tap tempo
-                    handle_tap_tempo(i);
-                }
-                else
-                {
-                    g_foot_value[i] = 1.0;
-                }
-            }
-
-            else if (button_status == BUTTON_RELEASED)
-            {
-                if (g_current_assignment[i]->mode & (CC_MODE_TRIGGER | CC_MODE_OPTIONS) && !(g_current_assignment[i]->mode & CC_MODE_COLOURED))
-                {
-                    //update leds
-                    hw_led_set(i, LED_W, LED_OFF,0,0);
-                    hw_led_set(i, LED_G, LED_ON,0,0);
-                }
-                if (g_tap_tempo[i].state != TT_COUNTING)
-                {
-                   g_foot_value[i] = 0.0;
-                }
+                update_leds(g_current_assignment[i]);
+                lcd_refresh(i);
             }
         }
-
-        cc_process();
     }
 
+    hw_button_notify(button_event);
+
+    // expression pedal
+    expression_init(ADC_SUM_MAX);
+    adc_init(adc_sample);
+
+    // init serial
+    g_serial = serial_init(g_baud_rates[0], serial_recv);
+
+    sched_run();
+
     return 0;
 }
 
@@ -0,0 +1,196 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <string.h>
+#include "page.h"
+#include "clcd.h"
+#include "hardware.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define LCD_OF(foot)        (((foot) & 0x02) >> 1)
+#define LINE_OF(foot)       ((foot) & 0x01)
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+// pins of each colour, R G B in the bits 0 1 2
+static const uint8_t g_colour_pins[] = {
+    [LED_R] = 0x01, [LED_G] = 0x02, [LED_B] = 0x04,
+    [LED_Y] = 0x03, [LED_C] = 0x06, [LED_M] = 0x05, [LED_W] = 0x07,
+};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct page_led_t {
+    int8_t colour;
+    uint16_t on_time, off_time;
+} page_led_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static int g_current_page;
+
+// lines and LEDs of every page, rendered when the assignments change
+static char g_lines[ACTUATORS_COUNT][PAGE_COLUMNS + 1];
+static page_led_t g_leds[ACTUATORS_COUNT];
+
+// what the displays show, zero where it isn't known
+static char g_shown[FOOTSWITCHES_COUNT][PAGE_COLUMNS + 1];
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void led_commit(int foot, const page_led_t *led)
+{
+    uint8_t pins = (led->colour != PAGE_LED_OFF ? g_colour_pins[led->colour] : 0);
+
+    // each pin is written once, a colour that stays doesn't blink off
+    for (int colour = LED_R; colour <= LED_B; colour++)
+    {
+        if (!(pins & (1 << colour)))
+            hw_led(foot, colour, LED_OFF);
+    }
+
+    if (led->colour != PAGE_LED_OFF)
+        hw_led_set(foot, led->colour, LED_ON, led->on_time, led->off_time);
+    else
+        hw_led_set(foot, LED_W, LED_OFF, 0, 0);
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+void page_init(void)
+{
+    for (int i = 0; i < ACTUATORS_COUNT; i++)
+    {
+        memset(g_lines[i], ' ', PAGE_COLUMNS);
+        g_leds[i].colour = PAGE_LED_OFF;
+    }
+
+    page_invalidate();
+}
+
+int page_current(void)
+{
+    return g_current_page;
+}
+
+// the LEDs of the page are shown right away, the lines by the next page_draw_next calls
+void page_select(int page)
+{
+    if (page < 0 || page >= PAGES_COUNT)
+        return;
+
+    g_current_page = page;
+
+    for (int foot = 0; foot < FOOTSWITCHES_COUNT; foot++)
+        led_commit(foot, &g_leds[page * FOOTSWITCHES_COUNT + foot]);
+}
+
+char *page_line(int actuator)
+{
+    return g_lines[actuator];
+}
+
+// writes only the characters that differ from what the display shows
+int page_draw(int actuator)
+{
+    if (PAGE_OF(actuator) != g_current_page)
+        return 0;
+
+    int foot = PAGE_FOOT(actuator);
+    const char *line = g_lines[actuator];
+    char *shown = g_shown[foot];
+
+    int first = 0, last = PAGE_COLUMNS - 1;
+    while (first < PAGE_COLUMNS && line[first] == shown[first])
+        first++;
+
+    if (first == PAGE_COLUMNS)
+        return 0;
+
+    while (line[last] == shown[last])
+        last--;
+
+    char text[PAGE_COLUMNS + 1];
+    memcpy(text, &line[first], last - first + 1);
+    text[last - first + 1] = 0;
+
+    clcd_cursor_set(LCD_OF(foot), LINE_OF(foot), first);
+    clcd_print(LCD_OF(foot), text);
+
+    memcpy(&shown[first], &line[first], last - first + 1);
+    return 1;
+}
+
+// draws the first line of the current page that differs from the display, returns zero when all of
+// them were already shown
+int page_draw_next(void)
+{
+    for (int foot = 0; foot < FOOTSWITCHES_COUNT; foot++)
+    {
+        if (page_draw(g_current_page * FOOTSWITCHES_COUNT + foot))
+            return 1;
+    }
+
+    return 0;
+}
+
+// the displays were cleared
+void page_cleared(void)
+{
+    for (int foot = 0; foot < FOOTSWITCHES_COUNT; foot++)
+        memset(g_shown[foot], ' ', PAGE_COLUMNS);
+}
+
+// something else was written on the displays, the next draws write the whole lines
+void page_invalidate(void)
+{
+    memset(g_shown, 0, sizeof(g_shown));
+}
+
+void page_led(int actuator, int colour, int on_time_ms, int off_time_ms)
+{
+    if (actuator >= ACTUATORS_COUNT)
+        return;
+
+    page_led_t *led = &g_leds[actuator];
+    led->colour = colour;
+    led->on_time = on_time_ms;
+    led->off_time = off_time_ms;
+
+    if (PAGE_OF(actuator) == g_current_page)
+        led_commit(PAGE_FOOT(actuator), led);
+}
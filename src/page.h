@@ -0,0 +1,77 @@
+#ifndef PAGE_H
+#define PAGE_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+#include "config.h"
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+// LED colour of an actuator without light
+#define PAGE_LED_OFF        -1
+
+// footswitch and page of an actuator
+#define PAGE_FOOT(actuator) ((actuator) % FOOTSWITCHES_COUNT)
+#define PAGE_OF(actuator)   ((actuator) / FOOTSWITCHES_COUNT)
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// characters of a display line
+#define PAGE_COLUMNS        16
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+void page_init(void);
+int page_current(void);
+void page_select(int page);
+
+// pre-rendered display line of an actuator, PAGE_COLUMNS characters
+char *page_line(int actuator);
+int page_draw(int actuator);
+int page_draw_next(void);
+void page_cleared(void);
+void page_invalidate(void);
+
+// LED state of an actuator, shown right away if its page is the current one
+void page_led(int actuator, int colour, int on_time_ms, int off_time_ms);
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+#if PAGES_COUNT < 1 || ACTUATORS_COUNT > 32
+#error "PAGES_COUNT must be at least 1 and the actuators of all pages must fit in 32 bits"
+#endif
+
+
+#endif
@@ -0,0 +1,152 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "predict.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct prediction_t {
+    uint8_t index;
+    // presses the host didn't answer yet
+    uint8_t presses;
+    uint32_t deadline;
+} prediction_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static prediction_t g_predictions[PREDICT_MAX_ACTUATORS];
+static predict_stats_t g_stats;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// the press of an options switch shows the next option before the host answers,
+// presses in a row advance from the option already predicted
+void predict_press(int actuator, int list_index, int list_count, uint32_t now_ms)
+{
+    if (actuator >= PREDICT_MAX_ACTUATORS || list_count <= 0)
+        return;
+
+    const prediction_t *prediction = &g_predictions[actuator];
+    int from = (prediction->presses ? prediction->index : list_index);
+
+    predict_set(actuator, (from + 1) % list_count, now_ms);
+}
+
+// the switch sets the value itself, as the momentary ones do
+void predict_set(int actuator, int index, uint32_t now_ms)
+{
+    if (actuator >= PREDICT_MAX_ACTUATORS)
+        return;
+
+    prediction_t *prediction = &g_predictions[actuator];
+    prediction->index = index;
+    prediction->deadline = now_ms + PREDICT_TIMEOUT;
+
+    if (prediction->presses < UINT8_MAX)
+        prediction->presses++;
+}
+
+// option or value to be shown, the predicted one while the host didn't answer
+int predict_index(int actuator, int list_index)
+{
+    if (actuator >= PREDICT_MAX_ACTUATORS || !g_predictions[actuator].presses)
+        return list_index;
+
+    return g_predictions[actuator].index;
+}
+
+// the host sent the option or value, returns 1 if the prediction was wrong and the shown option goes back
+int predict_confirm(int actuator, int list_index)
+{
+    if (actuator >= PREDICT_MAX_ACTUATORS)
+        return 0;
+
+    prediction_t *prediction = &g_predictions[actuator];
+    if (!prediction->presses)
+        return 0;
+
+    if (prediction->index == list_index)
+    {
+        g_stats.hits++;
+        prediction->presses = 0;
+        return 0;
+    }
+
+    // the answers to the first presses of a sequence can't match the last prediction
+    if (--prediction->presses > 0)
+        return 0;
+
+    g_stats.mismatches++;
+    return 1;
+}
+
+// returns the actuators whose predictions the host didn't answer in time
+uint32_t predict_expire(uint32_t now_ms)
+{
+    uint32_t expired = 0;
+
+    for (int i = 0; i < PREDICT_MAX_ACTUATORS; i++)
+    {
+        prediction_t *prediction = &g_predictions[i];
+
+        if (prediction->presses && (int32_t) (now_ms - prediction->deadline) >= 0)
+        {
+            prediction->presses = 0;
+            g_stats.timeouts++;
+            expired |= (1UL << i);
+        }
+    }
+
+    return expired;
+}
+
+// a new assignment or an unassignment makes the prediction meaningless
+void predict_cancel(int actuator)
+{
+    if (actuator < PREDICT_MAX_ACTUATORS)
+        g_predictions[actuator].presses = 0;
+}
+
+const predict_stats_t *predict_stats(void)
+{
+    return &g_stats;
+}
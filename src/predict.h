@@ -0,0 +1,67 @@
+#ifndef PREDICT_H
+#define PREDICT_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+#include "config.h"
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// maximum number of actuators handled by the prediction (the ones of the pages, the gestures and
+// the expression pedal are never predicted)
+#define PREDICT_MAX_ACTUATORS   ACTUATORS_COUNT
+// time the host has to answer a press before the predicted option or value is rolled back (in milliseconds)
+#define PREDICT_TIMEOUT         500
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct predict_stats_t {
+    uint32_t hits, mismatches, timeouts;
+} predict_stats_t;
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+void predict_press(int actuator, int list_index, int list_count, uint32_t now_ms);
+void predict_set(int actuator, int index, uint32_t now_ms);
+int predict_index(int actuator, int list_index);
+int predict_confirm(int actuator, int list_index);
+uint32_t predict_expire(uint32_t now_ms);
+void predict_cancel(int actuator);
+const predict_stats_t *predict_stats(void);
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+
+#endif
@@ -0,0 +1,158 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <string.h>
+#include "chip.h"
+#include "prof.h"
+#include "hardware.h"
+
+#ifdef PROFILE
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define NAME_SIZE   8
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+static const char *g_names[PROF_REGIONS] = PROF_NAMES;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static prof_region_t g_regions[PROF_REGIONS] = {
+    [0 ... PROF_REGIONS - 1] = {.min = 0xFFFFFFFF}
+};
+
+// regions being run, innermost last: start and cycles of the regions entered inside
+static uint32_t g_start[PROF_MAX_DEPTH], g_nested[PROF_MAX_DEPTH];
+static int g_depth;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static void put_u32(uint8_t *buffer, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        buffer[i] = (value >> (i * 8)) & 0xFF;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// an interrupt can come between the reads of the cycles and the stack update, they go together
+// the regions past PROF_MAX_DEPTH are not accounted
+void prof_enter(int region)
+{
+    (void) region;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (g_depth < PROF_MAX_DEPTH)
+    {
+        g_nested[g_depth] = 0;
+        g_start[g_depth] = hw_cycles();
+    }
+
+    g_depth++;
+    __set_PRIMASK(primask);
+}
+
+void prof_exit(int region)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t now = hw_cycles();
+    int depth = --g_depth;
+
+    if (depth >= PROF_MAX_DEPTH)
+    {
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    uint32_t elapsed = now - g_start[depth];
+    uint32_t cycles = elapsed - g_nested[depth];
+
+    // the enclosing region doesn't count this one
+    if (depth > 0)
+        g_nested[depth - 1] += elapsed;
+
+    prof_region_t *r = &g_regions[region];
+    r->calls++;
+    r->total += cycles;
+
+    if (cycles < r->min)
+        r->min = cycles;
+
+    if (cycles > r->max)
+        r->max = cycles;
+
+    __set_PRIMASK(primask);
+}
+
+const prof_region_t *prof_region(int region)
+{
+    return &g_regions[region];
+}
+
+// header: magic, number of regions, cycles per millisecond, uptime in milliseconds
+// region: name (8 bytes), calls, min, max, total (low and high words), all little endian
+void prof_dump(void (*write_cb)(const uint8_t *data, uint32_t size))
+{
+    uint8_t buffer[NAME_SIZE + 5*4];
+
+    memcpy(buffer, PROF_MAGIC, 4);
+    put_u32(&buffer[4], PROF_REGIONS);
+    put_u32(&buffer[8], hw_cycles_per_ms());
+    put_u32(&buffer[12], hw_uptime());
+    write_cb(buffer, 16);
+
+    for (int i = 0; i < PROF_REGIONS; i++)
+    {
+        prof_region_t r = g_regions[i];
+
+        memset(buffer, 0, NAME_SIZE);
+        strncpy((char *) buffer, g_names[i], NAME_SIZE);
+        put_u32(&buffer[NAME_SIZE + 0], r.calls);
+        put_u32(&buffer[NAME_SIZE + 4], r.calls ? r.min : 0);
+        put_u32(&buffer[NAME_SIZE + 8], r.max);
+        put_u32(&buffer[NAME_SIZE + 12], r.total & 0xFFFFFFFF);
+        put_u32(&buffer[NAME_SIZE + 16], r.total >> 32);
+        write_cb(buffer, sizeof(buffer));
+    }
+}
+
+#endif
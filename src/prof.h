@@ -0,0 +1,92 @@
+#ifndef PROF_H
+#define PROF_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+// profiled regions, keep PROF_NAMES in the same order
+enum {
+    PROF_SYSTICK,
+    PROF_UART,
+    PROF_TIMER,
+    PROF_CC_PROCESS,
+    PROF_CLCD_PRINT,
+    PROF_DELAY_US,
+    PROF_PININT,
+    PROF_ADC,
+    PROF_REGIONS
+};
+
+#define PROF_NAMES  {"systick", "uart", "timer", "cc_proc", "clcd", "delay_us", "pinint", "adc"}
+
+// dump header
+#define PROF_MAGIC  "CCPF"
+
+#ifdef PROFILE
+#define PROF_ENTER(region)  prof_enter(region)
+#define PROF_EXIT(region)   prof_exit(region)
+#else
+#define PROF_ENTER(region)  ((void) 0)
+#define PROF_EXIT(region)   ((void) 0)
+#endif
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// regions that can be entered one inside the other (main loop, delay and nested interrupts)
+#define PROF_MAX_DEPTH  6
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+// the cycles of a region exclude the ones of the regions entered inside it (an interrupt, a delay),
+// the time of an interrupt without a region is counted in the region it preempted
+typedef struct prof_region_t {
+    uint32_t calls;
+    uint32_t min, max;
+    uint64_t total;
+} prof_region_t;
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+#ifdef PROFILE
+void prof_enter(int region);
+void prof_exit(int region);
+const prof_region_t *prof_region(int region);
+void prof_dump(void (*write_cb)(const uint8_t *data, uint32_t size));
+#endif
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+
+#endif
@@ -0,0 +1,279 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "chip.h"
+#include "sched.h"
+#include "hardware.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+// the cpu is running, sleeping or woken by an interrupt which entry was stamped
+enum {WAKE_NONE, WAKE_SLEEPING, WAKE_STAMPED};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct task_t {
+    sched_task_config_t config;
+    volatile uint32_t events;
+    volatile uint32_t ready_time;
+    volatile uint8_t ready;
+    uint32_t next_run;
+    // one-shot wakeup armed by sched_wakeup
+    uint32_t wakeup_time;
+    uint8_t wakeup_armed;
+    sched_stats_t stats;
+} task_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static task_t g_tasks[SCHED_MAX_TASKS];
+static int g_tasks_count;
+static uint32_t g_deadline_min;
+static sched_idle_stats_t g_idle;
+static uint32_t g_start_time;
+static volatile uint8_t g_wake;
+static volatile uint32_t g_wake_time;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// must be called with interrupts disabled or from the main loop
+static inline void task_ready(task_t *task)
+{
+    if (!task->ready)
+    {
+        task->ready = 1;
+        task->ready_time = hw_time_us();
+    }
+}
+
+// marks the periodic tasks which period elapsed as ready, returns the ready task to run
+static task_t* tasks_poll(void)
+{
+    uint32_t now = hw_uptime();
+    task_t *next = 0;
+
+    for (int i = 0; i < g_tasks_count; i++)
+    {
+        task_t *task = &g_tasks[i];
+
+        // periodic tasks
+        if (task->config.period_ms && (int32_t) (now - task->next_run) >= 0)
+        {
+            task->next_run += task->config.period_ms;
+
+            // don't try to catch up if the task missed several periods
+            if ((int32_t) (now - task->next_run) >= 0)
+                task->next_run = now + task->config.period_ms;
+
+            task_ready(task);
+        }
+
+        if (task->wakeup_armed && (int32_t) (now - task->wakeup_time) >= 0)
+        {
+            task->wakeup_armed = 0;
+            task_ready(task);
+        }
+
+        if (task->ready && (!next || task->config.priority < next->config.priority))
+            next = task;
+    }
+
+    return next;
+}
+
+static void task_exec(task_t *task)
+{
+    __disable_irq();
+    uint32_t events = task->events;
+    uint32_t ready_time = task->ready_time;
+    task->events = 0;
+    task->ready = 0;
+    __enable_irq();
+
+    uint32_t start = hw_time_us();
+
+    // first task since the cpu woke up
+    if (g_wake == WAKE_STAMPED)
+    {
+        uint32_t wake = start - g_wake_time;
+        g_idle.wakes++;
+        g_idle.wake_total_us += wake;
+        if (wake > g_idle.wake_max_us)
+            g_idle.wake_max_us = wake;
+    }
+    g_wake = WAKE_NONE;
+
+    task->config.run(events);
+    uint32_t end = hw_time_us();
+
+    sched_stats_t *stats = &task->stats;
+    uint32_t latency = start - ready_time;
+    uint32_t runtime = end - start;
+
+    stats->runs++;
+    stats->runtime_total_us += runtime;
+
+    if (runtime > stats->runtime_max_us)
+        stats->runtime_max_us = runtime;
+
+    if (latency > stats->latency_max_us)
+        stats->latency_max_us = latency;
+
+    if (task->config.deadline_us && latency > task->config.deadline_us)
+        stats->deadline_misses++;
+
+    if (g_deadline_min && runtime > g_deadline_min)
+        stats->overruns++;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+int sched_task_add(const sched_task_config_t *config)
+{
+    if (g_tasks_count >= SCHED_MAX_TASKS)
+        return -1;
+
+    int task_id = g_tasks_count++;
+    task_t *task = &g_tasks[task_id];
+
+    task->config = *config;
+    task->stats.name = config->name;
+    task->next_run = hw_uptime() + config->period_ms;
+
+    if (config->deadline_us && (!g_deadline_min || config->deadline_us < g_deadline_min))
+        g_deadline_min = config->deadline_us;
+
+    return task_id;
+}
+
+// can be called from interrupts
+void sched_event(int task_id, uint32_t events)
+{
+    task_t *task = &g_tasks[task_id];
+
+    __disable_irq();
+    task->events |= events;
+    task_ready(task);
+    __enable_irq();
+}
+
+// wakes up the task once delay_ms elapsed, a sooner wakeup already armed is kept
+// must be called from the main loop
+void sched_wakeup(int task_id, uint32_t delay_ms)
+{
+    task_t *task = &g_tasks[task_id];
+    uint32_t time = hw_uptime() + delay_ms;
+
+    if (!task->wakeup_armed || (int32_t) (time - task->wakeup_time) < 0)
+    {
+        task->wakeup_time = time;
+        task->wakeup_armed = 1;
+    }
+}
+
+// runs the ready task with the highest priority, returns zero if no task was ready
+int sched_run_once(void)
+{
+    task_t *next = tasks_poll();
+
+    if (!next)
+        return 0;
+
+    task_exec(next);
+    return 1;
+}
+
+// sleeps until the next interrupt if no task is ready
+void sched_idle(void)
+{
+    // interrupts are disabled so an event set after the check still wakes up the cpu
+    __disable_irq();
+
+    if (!tasks_poll())
+    {
+        uint32_t start = hw_time_us();
+        g_wake = WAKE_SLEEPING;
+        Chip_PMU_SleepState(LPC_PMU);
+        uint32_t end = hw_time_us();
+
+        g_idle.sleeps++;
+        g_idle.idle_us += (end - start);
+    }
+
+    __enable_irq();
+}
+
+// must be called first thing by the interrupt handlers, the ones that wake up the cpu start the
+// wake latency
+void sched_irq_entry(void)
+{
+    if (g_wake == WAKE_SLEEPING)
+    {
+        g_wake_time = hw_time_us();
+        g_wake = WAKE_STAMPED;
+    }
+}
+
+void sched_run(void)
+{
+    g_start_time = hw_uptime();
+
+    while (1)
+    {
+        if (!sched_run_once())
+            sched_idle();
+    }
+}
+
+void sched_idle_stats(sched_idle_stats_t *stats)
+{
+    __disable_irq();
+    *stats = g_idle;
+    __enable_irq();
+
+    stats->elapsed_us = (uint64_t) (hw_uptime() - g_start_time) * 1000;
+}
+
+int sched_stats(int task_id, sched_stats_t *stats)
+{
+    if (task_id < 0 || task_id >= g_tasks_count)
+        return -1;
+
+    *stats = g_tasks[task_id].stats;
+    return 0;
+}
@@ -0,0 +1,93 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+// event sent by sched_event to wake up a task that has no events of its own
+#define SCHED_EV_WAKEUP     (1 << 0)
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+#define SCHED_MAX_TASKS     8
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct sched_task_config_t {
+    const char *name;
+    // called with the pending events (zero when called by the period)
+    void (*run)(uint32_t events);
+    // lower value runs first
+    uint8_t priority;
+    // zero for tasks only woken up by events and sched_wakeup
+    uint32_t period_ms;
+    // maximum time between the task be ready and start to run
+    uint32_t deadline_us;
+} sched_task_config_t;
+
+typedef struct sched_stats_t {
+    const char *name;
+    uint32_t runs, deadline_misses;
+    // runs longer than the shortest deadline of the tasks, which can make the others miss theirs
+    uint32_t overruns;
+    uint32_t latency_max_us;
+    uint32_t runtime_total_us, runtime_max_us;
+} sched_stats_t;
+
+
+typedef struct sched_idle_stats_t {
+    uint32_t sleeps;
+    uint64_t idle_us, elapsed_us;
+    // time from the first interrupt entry after a sleep until the first task runs
+    uint32_t wakes, wake_max_us;
+    uint64_t wake_total_us;
+} sched_idle_stats_t;
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+int sched_task_add(const sched_task_config_t *config);
+void sched_event(int task_id, uint32_t events);
+void sched_wakeup(int task_id, uint32_t delay_ms);
+int sched_run_once(void);
+void sched_idle(void);
+void sched_irq_entry(void);
+void sched_run(void);
+int sched_stats(int task_id, sched_stats_t *stats);
+void sched_idle_stats(sched_idle_stats_t *stats);
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+
+#endif
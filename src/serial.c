@@ -4,8 +4,16 @@
 ****************************************************************************************************
 */
 
+#include <string.h>
 #include "chip.h"
 #include "serial.h"
+#include "baud.h"
+#include "timer.h"
+#include "trace.h"
+#include "latency.h"
+#include "hardware.h"
+#include "prof.h"
+#include "sched.h"
 
 
 /*
@@ -15,6 +23,10 @@
 */
 
 #define RX_BUFFER_SIZE  64
+#define TX_BUFFER_SIZE  128
+
+// start + 8 data + stop bits
+#define BITS_PER_CHAR   10
 
 #define DRIVER_ENABLE(v)    Chip_GPIO_SetPinState(LPC_GPIO, SERIAL_DE_PORT, SERIAL_DE_PIN, v);
 
@@ -32,10 +44,23 @@
 ****************************************************************************************************
 */
 
+// driver enable states
+enum {DE_IDLE, DE_SETUP, DE_SENDING, DE_HOLD};
+
 typedef struct serial_t {
-    RINGBUFF_T rx_rb;
+    RINGBUFF_T rx_rb, tx_rb;
     uint8_t rx_buffer[RX_BUFFER_SIZE];
+    uint8_t tx_buffer[TX_BUFFER_SIZE];
     void (*receive_cb)(void *arg);
+    volatile uint8_t de_state;
+    uint32_t char_time_us;
+    // part of the frame that didn't fit in the transmit buffer, moved in as the uart takes bytes
+    uint8_t tx_frame[SERIAL_FRAME_SIZE];
+    const uint8_t *tx_pending;
+    volatile uint32_t tx_pending_size;
+    // time the last bytes were read from the fifo
+    volatile uint32_t rx_time;
+    serial_stats_t stats;
 } serial_t;
 
 
@@ -54,18 +79,91 @@ static serial_t g_serial;
 ****************************************************************************************************
 */
 
+// stops the uart and timer interrupts of changing the driver enable state
+static inline void de_lock(void)
+{
+    NVIC_DisableIRQ(UART0_IRQn);
+    NVIC_DisableIRQ(TIMER_32_0_IRQn);
+}
+
+static inline void de_unlock(void)
+{
+    NVIC_EnableIRQ(TIMER_32_0_IRQn);
+    NVIC_EnableIRQ(UART0_IRQn);
+}
+
+// must be called with the uart interrupt disabled or from the uart and timer interrupts
+static void tx_fill(serial_t *serial)
+{
+    if (serial->tx_pending_size == 0)
+        return;
+
+    uint32_t written = RingBuffer_InsertMult(&serial->tx_rb, serial->tx_pending, serial->tx_pending_size);
+    trace_record(TRACE_TX, serial->tx_pending, written);
+    serial->tx_pending += written;
+    serial->tx_pending_size -= written;
+}
+
+// driver enable setup and hold times are counted by the timer match
+static void de_timer_cb(void)
+{
+    serial_t *serial = &g_serial;
+
+    if (serial->de_state == DE_SETUP)
+    {
+        // driver is enabled, start to fill the fifo
+        serial->de_state = DE_SENDING;
+        Chip_UART_TXIntHandlerRB(LPC_USART, &serial->tx_rb);
+        tx_fill(serial);
+        Chip_UART_IntEnable(LPC_USART, UART_IER_THREINT);
+    }
+    else if (serial->de_state == DE_HOLD)
+    {
+        // last stop bit is out, release the bus
+        serial->de_state = DE_IDLE;
+        DRIVER_ENABLE(0);
+        latency_frame(LAT_WIRE);
+    }
+}
+
 void UART_IRQHandler(void)
 {
+    sched_irq_entry();
+    PROF_ENTER(PROF_UART);
     serial_t *serial = &g_serial;
 
     // TODO: handle errors
 
+    // transmitter holding register empty
+    if (serial->de_state == DE_SENDING &&
+        (Chip_UART_ReadLineStatus(LPC_USART) & UART_LSR_THRE))
+    {
+        Chip_UART_TXIntHandlerRB(LPC_USART, &serial->tx_rb);
+
+        // the rest of a frame bigger than the buffer follows the bytes taken by the uart
+        tx_fill(serial);
+
+        // the last byte was moved to the shift register, release the bus after its stop bit
+        if (RingBuffer_IsEmpty(&serial->tx_rb) &&
+            (Chip_UART_ReadLineStatus(LPC_USART) & UART_LSR_THRE))
+        {
+            Chip_UART_IntDisable(LPC_USART, UART_IER_THREINT);
+            serial->de_state = DE_HOLD;
+            timer_set(serial->char_time_us + SERIAL_DE_HOLD_US);
+        }
+    }
+
     // use default ring buffer handler
     Chip_UART_RXIntHandlerRB(LPC_USART, &serial->rx_rb);
 
     uint8_t buffer[RX_BUFFER_SIZE], read;
     read = Chip_UART_ReadRB(LPC_USART, &serial->rx_rb, &buffer, sizeof(buffer));
 
+    trace_record(TRACE_RX, buffer, read);
+
+    if (read > 0)
+        serial->rx_time = hw_time_us();
+
     if (read > 0 && serial->receive_cb)
     {
         serial_data_t sdata;
@@ -73,6 +171,8 @@ void UART_IRQHandler(void)
         sdata.size = read;
         serial->receive_cb(&sdata);
     }
+
+    PROF_EXIT(PROF_UART);
 }
 
 
@@ -95,7 +195,7 @@ serial_t* serial_init(uint32_t baud_rate, void (*receive_cb)(void *arg))
 
     // setup serial
     Chip_UART_Init(LPC_USART);
-    Chip_UART_SetBaud(LPC_USART, baud_rate);
+    serial_baud_rate_set(baud_rate);
     Chip_UART_ConfigData(LPC_USART, (UART_LCR_WLEN8 | UART_LCR_SBS_1BIT));
     Chip_UART_SetupFIFOS(LPC_USART, (UART_FCR_FIFO_EN | UART_FCR_TRG_LEV2));
     Chip_UART_TXEnable(LPC_USART);
@@ -107,8 +207,15 @@ serial_t* serial_init(uint32_t baud_rate, void (*receive_cb)(void *arg))
     NVIC_SetPriority(UART0_IRQn, 1);
     NVIC_EnableIRQ(UART0_IRQn);
 
+    // driver enable timer has the same priority of the uart so they don't preempt each other
+    timer_init(de_timer_cb);
+    NVIC_SetPriority(TIMER_32_0_IRQn, 1);
+
     // create ring buffers
     RingBuffer_Init(&serial->rx_rb, &serial->rx_buffer, 1, RX_BUFFER_SIZE);
+    RingBuffer_Init(&serial->tx_rb, &serial->tx_buffer, 1, TX_BUFFER_SIZE);
+    serial->de_state = DE_IDLE;
+    serial->tx_pending_size = 0;
 
     // set serial callback
     serial->receive_cb = receive_cb;
@@ -116,24 +223,93 @@ serial_t* serial_init(uint32_t baud_rate, void (*receive_cb)(void *arg))
     return serial;
 }
 
+// never waits, it is called from the uart interrupt when the library answers a frame
+// the data is copied, a frame sent while the previous one still waits for room or that doesn't
+// fit is dropped and counted (the master only polls again once it got the answer)
 void serial_send(serial_t *serial, serial_data_t *sdata)
 {
-    (void) serial;
+    latency_frame(LAT_ENQUEUE);
 
-    DRIVER_ENABLE(1);
+    de_lock();
 
-    // wait driver to enable
-    for (volatile int delay = 0; delay < 100; delay++);
+    if (serial->tx_pending_size > 0 ||
+        sdata->size > (uint32_t) RingBuffer_GetFree(&serial->tx_rb) + SERIAL_FRAME_SIZE)
+    {
+        serial->stats.dropped++;
+        de_unlock();
+        return;
+    }
 
-    if (sdata->size > 0)
-        Chip_UART_SendBlocking(LPC_USART, sdata->data, sdata->size);
+    serial->stats.frames++;
+    serial->tx_pending = sdata->data;
+    serial->tx_pending_size = sdata->size;
+    tx_fill(serial);
 
-    while ((Chip_UART_ReadLineStatus(LPC_USART) & UART_LSR_TEMT) == 0);
+    // the rest waits in the driver, the caller can reuse its buffer
+    if (serial->tx_pending_size > 0)
+    {
+        memcpy(serial->tx_frame, serial->tx_pending, serial->tx_pending_size);
+        serial->tx_pending = serial->tx_frame;
+    }
 
-    DRIVER_ENABLE(0);
+    if (serial->de_state == DE_IDLE)
+    {
+        // enable driver and wait the setup time before the first start bit
+        serial->de_state = DE_SETUP;
+        DRIVER_ENABLE(1);
+        timer_set(SERIAL_DE_SETUP_US);
+    }
+    else if (serial->de_state == DE_HOLD)
+    {
+        // bus is still ours, cancel the release and keep sending
+        serial->de_state = DE_SENDING;
+        Chip_UART_TXIntHandlerRB(LPC_USART, &serial->tx_rb);
+        tx_fill(serial);
+        Chip_UART_IntEnable(LPC_USART, UART_IER_THREINT);
+    }
+
+    de_unlock();
+}
+
+// bytes of the last frame that are not in the transmit buffer yet
+uint32_t serial_tx_pending(serial_t *serial)
+{
+    return serial->tx_pending_size;
+}
+
+// nonzero while the fifo has bytes or the last ones came less than SERIAL_RX_GAP_CHARS ago
+int serial_receiving(serial_t *serial)
+{
+    if (Chip_UART_ReadLineStatus(LPC_USART) & UART_LSR_RDR)
+        return 1;
+
+    return (hw_time_us() - serial->rx_time) < (SERIAL_RX_GAP_CHARS * serial->char_time_us);
+}
+
+uint32_t serial_baud_rate_set(uint32_t baud_rate)
+{
+    baud_divider_t divider;
+
+    // uart clock divider is set to 1 by Chip_UART_Init
+    uint32_t rate = baud_divider_calc(Chip_Clock_GetMainClockRate(), baud_rate, &divider);
+
+    // keep current configuration if rate can't be generated with acceptable error
+    if (rate == 0 || baud_error_ppm(baud_rate, rate) > BAUD_MAX_ERROR_PPM)
+        return 0;
+
+    Chip_UART_EnableDivisorAccess(LPC_USART);
+    Chip_UART_SetDivisorLatches(LPC_USART, UART_LOAD_DLL(divider.dl), UART_LOAD_DLM(divider.dl));
+    Chip_UART_DisableDivisorAccess(LPC_USART);
+
+    LPC_USART->FDR = (UART_FDR_MULVAL(divider.mulval) | UART_FDR_DIVADDVAL(divider.divaddval));
+
+    // time to shift out one character, used to release the bus after the last stop bit
+    g_serial.char_time_us = ((BITS_PER_CHAR * 1000000) + rate - 1) / rate;
+
+    return rate;
 }
 
-void serial_baud_rate_set(uint32_t baud_rate)
+const serial_stats_t *serial_stats(void)
 {
-    Chip_UART_SetBaud(LPC_USART, baud_rate);
+    return &g_serial.stats;
 }
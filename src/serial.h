@@ -26,6 +26,19 @@
 #define SERIAL_DE_PORT  0
 #define SERIAL_DE_PIN   16
 
+// RS-485 driver enable setup time (before the first start bit) and
+// hold time (after the last stop bit) in microseconds
+#define SERIAL_DE_SETUP_US  2
+#define SERIAL_DE_HOLD_US   0
+
+// part of a frame that doesn't fit in the transmit buffer is copied here, the largest frame is
+// this plus the free room of the transmit buffer (128 bytes)
+#define SERIAL_FRAME_SIZE   256
+
+// a frame is being received until the line was quiet for this many characters, more than the
+// receive fifo trigger level (8 characters) so the interrupts of a frame don't look like gaps
+#define SERIAL_RX_GAP_CHARS 10
+
 
 /*
 ****************************************************************************************************
@@ -40,6 +53,11 @@ typedef struct serial_data_t {
     uint32_t size;
 } serial_data_t;
 
+typedef struct serial_stats_t {
+    // frames sent and frames dropped as the previous one was still waiting for room or too big
+    uint32_t frames, dropped;
+} serial_stats_t;
+
 
 /*
 ****************************************************************************************************
@@ -49,7 +67,10 @@ typedef struct serial_data_t {
 
 serial_t *serial_init(uint32_t baud_rate, void (*receive_cb)(void *arg));
 void serial_send(serial_t *serial, serial_data_t *sdata);
-void serial_baud_rate_set(uint32_t baud_rate);
+uint32_t serial_tx_pending(serial_t *serial);
+int serial_receiving(serial_t *serial);
+uint32_t serial_baud_rate_set(uint32_t baud_rate);
+const serial_stats_t *serial_stats(void);
 
 
 /*
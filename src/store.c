@@ -0,0 +1,499 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <string.h>
+#include "store.h"
+#include "strpool.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+#define AREA_PAGES          (STORE_AREA_SIZE / EEPROM_PAGE)
+#define RECORD_PAGES(size)  (((size) + EEPROM_PAGE - 1) / EEPROM_PAGE)
+#define OPTIONS_MODES       (CC_MODE_OPTIONS | CC_MODE_COLOURED)
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+enum {STORE_IDLE, STORE_WRITING};
+
+// serializer cursor, only the record bytes in [start, end) are copied to the buffer
+typedef struct writer_t {
+    uint32_t pos, start, end;
+    uint8_t *buffer;
+    uint16_t crc;
+} writer_t;
+
+// parser cursor, the record is read from the EEPROM one page at a time
+typedef struct reader_t {
+    uint32_t page, pos, size;
+    int32_t cached;
+    uint16_t crc;
+    uint8_t error;
+} reader_t;
+
+typedef struct record_t {
+    uint32_t page, pages, seq;
+    uint16_t size, crc;
+} record_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static cc_assignment_t **g_assignments;
+static int g_count;
+
+static cc_assignment_t g_restored[STORE_MAX_ACTUATORS];
+static uint8_t g_items_first[STORE_MAX_ACTUATORS];
+static strpool_t g_items_label[STORE_RESTORE_ITEMS];
+static float g_items_value[STORE_RESTORE_ITEMS];
+
+static uint8_t g_page[EEPROM_PAGE];
+static uint8_t g_dirty, g_state, g_valid;
+static uint32_t g_changed_time;
+
+// last record in the EEPROM and the one being written
+static record_t g_last, g_write;
+static uint32_t g_write_index;
+
+static store_stats_t g_stats;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// CRC-16/CCITT
+static uint16_t crc16(uint16_t crc, uint8_t byte)
+{
+    crc ^= (uint16_t) byte << 8;
+    for (int i = 0; i < 8; i++)
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+
+    return crc;
+}
+
+static uint32_t page_address(uint32_t page)
+{
+    return STORE_AREA_START + ((page % AREA_PAGES) * EEPROM_PAGE);
+}
+
+static void put(writer_t *writer, const void *data, uint32_t size)
+{
+    const uint8_t *bytes = data;
+
+    for (uint32_t i = 0; i < size; i++, writer->pos++)
+    {
+        writer->crc = crc16(writer->crc, bytes[i]);
+
+        if (writer->pos >= writer->start && writer->pos < writer->end)
+            writer->buffer[writer->pos - writer->start] = bytes[i];
+    }
+}
+
+static void put_u8(writer_t *writer, uint8_t value)
+{
+    put(writer, &value, sizeof(value));
+}
+
+static void put_str(writer_t *writer, const str16_t *str)
+{
+    uint8_t size = (str->size > 16 ? 16 : str->size);
+    put_u8(writer, size);
+    put(writer, str->text, size);
+}
+
+// writes the record body of the current assignments (the header is written apart)
+static void serialize(writer_t *writer)
+{
+    uint8_t count = 0;
+    for (int i = 0; i < g_count; i++)
+    {
+        if (g_assignments[i] && g_assignments[i]->mode)
+            count++;
+    }
+
+    writer->pos = STORE_HEADER_SIZE;
+    writer->crc = 0xFFFF;
+    put_u8(writer, count);
+
+    for (int i = 0; i < g_count; i++)
+    {
+        cc_assignment_t *assignment = g_assignments[i];
+        if (!assignment || !assignment->mode)
+            continue;
+
+        uint16_t mode = assignment->mode;
+        uint8_t list_count = ((assignment->mode & OPTIONS_MODES) ? assignment->list_count : 0);
+
+        put_u8(writer, i);
+        put(writer, &mode, sizeof(mode));
+        put_str(writer, &assignment->label);
+        put_str(writer, &assignment->unit);
+        put(writer, &assignment->value, sizeof(float));
+        put(writer, &assignment->min, sizeof(float));
+        put(writer, &assignment->max, sizeof(float));
+        put_u8(writer, assignment->list_index);
+        put_u8(writer, list_count);
+
+        for (int j = 0; j < list_count; j++)
+        {
+            // the restored items live in the string pool
+            if (assignment == &g_restored[i])
+            {
+                int item = g_items_first[i] + j;
+                uint8_t size = strpool_size(g_items_label[item]);
+                put_u8(writer, size);
+                put(writer, strpool_text(g_items_label[item]), size);
+                put(writer, &g_items_value[item], sizeof(float));
+            }
+            else
+            {
+                put_str(writer, &assignment->list_items[j]->label);
+                put(writer, &assignment->list_items[j]->value, sizeof(float));
+            }
+        }
+    }
+}
+
+static void get(reader_t *reader, void *data, uint32_t size)
+{
+    uint8_t *bytes = data;
+
+    for (uint32_t i = 0; i < size; i++, reader->pos++)
+    {
+        if (reader->pos >= reader->size)
+        {
+            reader->error = 1;
+            bytes[i] = 0;
+            continue;
+        }
+
+        int32_t page = reader->pos / EEPROM_PAGE;
+        if (page != reader->cached)
+        {
+            if (hw_eeprom_read(page_address(reader->page + page), g_page, EEPROM_PAGE) != 0)
+                reader->error = 1;
+
+            reader->cached = page;
+        }
+
+        bytes[i] = g_page[reader->pos % EEPROM_PAGE];
+
+        if (reader->pos >= STORE_HEADER_SIZE)
+            reader->crc = crc16(reader->crc, bytes[i]);
+    }
+}
+
+static uint8_t get_u8(reader_t *reader)
+{
+    uint8_t value;
+    get(reader, &value, sizeof(value));
+    return value;
+}
+
+static void get_str(reader_t *reader, str16_t *str)
+{
+    str->size = get_u8(reader);
+    if (str->size > 16)
+    {
+        reader->error = 1;
+        str->size = 0;
+    }
+
+    get(reader, str->text, str->size);
+    str->text[str->size] = 0;
+}
+
+// reads the header of the record starting at the page, the reader is left at the body
+static int record_open(reader_t *reader, uint32_t page, record_t *record)
+{
+    uint16_t magic;
+
+    reader->page = page;
+    reader->pos = 0;
+    reader->size = STORE_HEADER_SIZE;
+    reader->cached = -1;
+    reader->crc = 0xFFFF;
+    reader->error = 0;
+
+    get(reader, &magic, sizeof(magic));
+    get(reader, &record->size, sizeof(record->size));
+    get(reader, &record->seq, sizeof(record->seq));
+    get(reader, &record->crc, sizeof(record->crc));
+
+    if (reader->error || magic != STORE_MAGIC || record->size + STORE_HEADER_SIZE > STORE_RECORD_MAX)
+        return 0;
+
+    record->page = page;
+    record->pages = RECORD_PAGES(STORE_HEADER_SIZE + record->size);
+    reader->size = STORE_HEADER_SIZE + record->size;
+
+    return 1;
+}
+
+static int record_check(uint32_t page, record_t *record)
+{
+    reader_t reader;
+    if (!record_open(&reader, page, record))
+        return 0;
+
+    uint8_t byte;
+    while (reader.pos < reader.size && !reader.error)
+        get(&reader, &byte, sizeof(byte));
+
+    return (!reader.error && reader.crc == record->crc);
+}
+
+// decodes the record into the restored assignments, returns how many were restored
+static int record_restore(const record_t *record)
+{
+    reader_t reader;
+    record_t header;
+    record_open(&reader, record->page, &header);
+
+    int restored = 0, items = 0;
+    uint8_t count = get_u8(&reader);
+
+    for (int n = 0; n < count && !reader.error; n++)
+    {
+        cc_assignment_t assignment;
+        memset(&assignment, 0, sizeof(assignment));
+
+        uint8_t actuator = get_u8(&reader);
+        uint16_t mode;
+        get(&reader, &mode, sizeof(mode));
+        get_str(&reader, &assignment.label);
+        get_str(&reader, &assignment.unit);
+        get(&reader, &assignment.value, sizeof(float));
+        get(&reader, &assignment.min, sizeof(float));
+        get(&reader, &assignment.max, sizeof(float));
+        assignment.list_index = get_u8(&reader);
+        assignment.list_count = get_u8(&reader);
+
+        // the items that don't fit in the pool are skipped along with the assignment
+        uint32_t pool_used = strpool_used();
+        int keep = (actuator < g_count && items + assignment.list_count <= STORE_RESTORE_ITEMS);
+        if ((mode & OPTIONS_MODES) && assignment.list_index >= assignment.list_count)
+            keep = 0;
+
+        for (int j = 0; j < assignment.list_count; j++)
+        {
+            option_t item;
+            get_str(&reader, &item.label);
+            get(&reader, &item.value, sizeof(float));
+
+            if (keep)
+            {
+                g_items_label[items + j] = strpool_intern(item.label.text, item.label.size);
+                g_items_value[items + j] = item.value;
+
+                if (g_items_label[items + j] == STRPOOL_NONE)
+                    keep = 0;
+            }
+        }
+
+        // the labels it added to the pool go with it
+        if (!keep || reader.error)
+        {
+            strpool_release(pool_used);
+            continue;
+        }
+
+        // the items are read with store_item_label
+        assignment.id = -1;
+        assignment.actuator_id = actuator;
+        assignment.mode = mode;
+        assignment.list_items = 0;
+        g_items_first[actuator] = items;
+        items += assignment.list_count;
+
+        g_restored[actuator] = assignment;
+        g_assignments[actuator] = &g_restored[actuator];
+        restored++;
+    }
+
+    return restored;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// count can't be over STORE_MAX_ACTUATORS
+void store_init(cc_assignment_t **assignments, int count)
+{
+    g_assignments = assignments;
+    g_count = count;
+}
+
+// finds the newest valid record and shows its assignments until the host sends the current ones
+int store_restore(void)
+{
+    record_t record;
+
+    g_valid = 0;
+    strpool_reset();
+    for (uint32_t page = 0; page < AREA_PAGES; page++)
+    {
+        if (!record_check(page, &record))
+            continue;
+
+        if (!g_valid || (int32_t) (record.seq - g_last.seq) > 0)
+        {
+            g_last = record;
+            g_valid = 1;
+        }
+    }
+
+    return (g_valid ? record_restore(&g_last) : 0);
+}
+
+int store_provisional(int actuator)
+{
+    if (actuator >= g_count)
+        return 0;
+
+    return (g_assignments[actuator] == &g_restored[actuator] && g_restored[actuator].mode);
+}
+
+// label of an option item of a restored assignment, an empty one past its items
+const char *store_item_label(int actuator, int index, uint8_t *size)
+{
+    if (!store_provisional(actuator) || index < 0 || index >= g_restored[actuator].list_count)
+    {
+        *size = 0;
+        return "";
+    }
+
+    strpool_t label = g_items_label[g_items_first[actuator] + index];
+
+    *size = strpool_size(label);
+    return strpool_text(label);
+}
+
+void store_changed(void)
+{
+    g_dirty = 1;
+    g_changed_time = hw_uptime();
+}
+
+// writes at most one EEPROM page per call, returns the time until the next call is needed (in
+// milliseconds), zero when there is nothing to write
+uint32_t store_process(void)
+{
+    writer_t writer;
+    uint32_t settled = hw_uptime() - g_changed_time;
+
+    if (g_state == STORE_IDLE)
+    {
+        if (!g_dirty)
+            return 0;
+
+        if (settled < STORE_WRITE_DELAY)
+            return STORE_WRITE_DELAY - settled;
+
+        g_dirty = 0;
+
+        // size and crc of the record, nothing is copied
+        writer.start = writer.end = 0;
+        serialize(&writer);
+
+        uint16_t size = writer.pos - STORE_HEADER_SIZE;
+        // the assignments went back to what the EEPROM has (e.g. a value set and reset)
+        if (g_valid && size == g_last.size && writer.crc == g_last.crc)
+        {
+            g_stats.unchanged++;
+            return 0;
+        }
+
+        // the new record goes after the last one so this one stays valid until it's complete
+        g_write.page = (g_valid ? (g_last.page + g_last.pages) % AREA_PAGES : 0);
+        g_write.pages = RECORD_PAGES(STORE_HEADER_SIZE + size);
+        g_write.seq = g_last.seq + 1;
+        g_write.size = size;
+        g_write.crc = writer.crc;
+        g_write_index = 1;
+        g_state = STORE_WRITING;
+        return STORE_PAGE_INTERVAL;
+    }
+
+    // the assignments changed meanwhile, start over when they settle
+    if (g_dirty)
+    {
+        g_state = STORE_IDLE;
+        return (settled < STORE_WRITE_DELAY ? STORE_WRITE_DELAY - settled : 1);
+    }
+
+    // the first page has the header and goes last
+    uint32_t index = (g_write_index < g_write.pages ? g_write_index : 0);
+
+    memset(g_page, 0xFF, sizeof(g_page));
+    writer.start = index * EEPROM_PAGE;
+    writer.end = writer.start + EEPROM_PAGE;
+    writer.buffer = g_page;
+    serialize(&writer);
+
+    if (index == 0)
+    {
+        uint16_t magic = STORE_MAGIC;
+        memcpy(&g_page[0], &magic, sizeof(magic));
+        memcpy(&g_page[2], &g_write.size, sizeof(g_write.size));
+        memcpy(&g_page[4], &g_write.seq, sizeof(g_write.seq));
+        memcpy(&g_page[8], &g_write.crc, sizeof(g_write.crc));
+    }
+
+    if (hw_eeprom_write(page_address(g_write.page + index), g_page, EEPROM_PAGE) != 0)
+    {
+        // try again later
+        g_state = STORE_IDLE;
+        store_changed();
+        return STORE_WRITE_DELAY;
+    }
+
+    g_stats.pages++;
+
+    if (index == 0)
+    {
+        g_stats.records++;
+        g_last = g_write;
+        g_valid = 1;
+        g_state = STORE_IDLE;
+        return 0;
+    }
+
+    g_write_index++;
+    return STORE_PAGE_INTERVAL;
+}
+
+const store_stats_t *store_stats(void)
+{
+    return &g_stats;
+}
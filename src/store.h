@@ -0,0 +1,92 @@
+#ifndef STORE_H
+#define STORE_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+#include "hardware.h"
+#include "config.h"
+#include "control_chain.h"
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+// record header: magic (2), body size (2), sequence (4), body crc (2)
+#define STORE_MAGIC             0x5343
+#define STORE_HEADER_SIZE       10
+
+// largest record: count, per actuator id, mode, label, unit, value, min, max, index, items count
+// and the label and value of each option item
+#define STORE_RECORD_MAX        (STORE_HEADER_SIZE + 1 + (STORE_MAX_ACTUATORS * 51) + \
+                                 (CC_MAX_OPTIONS_ITEMS * 21))
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// maximum number of actuators handled by the store: the ones of the pages, the gestures and the
+// expression pedal have no display line or LED to show until the host sends their assignments
+#define STORE_MAX_ACTUATORS     ACTUATORS_COUNT
+// EEPROM area used as a circular log of records (in bytes, multiple of EEPROM_PAGE)
+#define STORE_AREA_START        0
+#define STORE_AREA_SIZE         EEPROM_SIZE
+// time without changes before the assignments are written (in milliseconds)
+#define STORE_WRITE_DELAY       2000
+// time between the pages of a record, the other tasks run in between (in milliseconds)
+#define STORE_PAGE_INTERVAL     10
+// option items that can be restored at power-up (shared by all actuators)
+// each takes 6 bytes plus its label in the string pool (shared by equal labels), the items the
+// host sends are allocated by the cc library (CC_MAX_OPTIONS_ITEMS) and the labels and units of
+// the restored assignments stay in their cc_assignment_t, where the display reads them
+#define STORE_RESTORE_ITEMS     48
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct store_stats_t {
+    // records written, EEPROM pages programmed and records not written as they didn't change
+    uint32_t records, pages, unchanged;
+} store_stats_t;
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+void store_init(cc_assignment_t **assignments, int count);
+int store_restore(void);
+int store_provisional(int actuator);
+const char *store_item_label(int actuator, int index, uint8_t *size);
+void store_changed(void);
+uint32_t store_process(void);
+const store_stats_t *store_stats(void);
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+// a new record is written after the last one, both must fit in the area
+#if (((STORE_RECORD_MAX + EEPROM_PAGE - 1) / EEPROM_PAGE) * 2) > (STORE_AREA_SIZE / EEPROM_PAGE)
+#error "STORE_AREA_SIZE can't hold two records of STORE_RECORD_MAX bytes"
+#endif
+
+#endif
@@ -0,0 +1,106 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <string.h>
+#include "strpool.h"
+#include "hardware.h"
+
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+// strings are stored back to back as: size, text, null terminator
+static uint8_t g_pool[STRPOOL_SIZE] USB_RAM;
+static uint16_t g_used;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// releases all strings at once
+void strpool_reset(void)
+{
+    g_used = 0;
+}
+
+// returns the handle of an equal string already in the pool or of a new copy
+strpool_t strpool_intern(const char *text, uint8_t size)
+{
+    uint32_t pos = 0;
+    while (pos < g_used)
+    {
+        if (g_pool[pos] == size && memcmp(&g_pool[pos + 1], text, size) == 0)
+            return pos;
+
+        pos += g_pool[pos] + 2;
+    }
+
+    if (g_used + size + 2 > STRPOOL_SIZE)
+        return STRPOOL_NONE;
+
+    g_pool[pos] = size;
+    memcpy(&g_pool[pos + 1], text, size);
+    g_pool[pos + 1 + size] = 0;
+    g_used += size + 2;
+
+    return pos;
+}
+
+const char *strpool_text(strpool_t handle)
+{
+    return (handle < g_used ? (const char *) &g_pool[handle + 1] : "");
+}
+
+uint8_t strpool_size(strpool_t handle)
+{
+    return (handle < g_used ? g_pool[handle] : 0);
+}
+
+uint32_t strpool_used(void)
+{
+    return g_used;
+}
+
+// drops the strings added since strpool_used returned used
+void strpool_release(uint32_t used)
+{
+    if (used < g_used)
+        g_used = used;
+}
@@ -0,0 +1,67 @@
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+// handle returned when the pool is full
+#define STRPOOL_NONE        0xFFFF
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// size of the pool in bytes (placed in the USB RAM, along with the trace buffer)
+// each string takes its size plus two bytes (size prefix and null terminator)
+#define STRPOOL_SIZE        512
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+typedef uint16_t strpool_t;
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+void strpool_reset(void);
+strpool_t strpool_intern(const char *text, uint8_t size);
+const char *strpool_text(strpool_t handle);
+uint8_t strpool_size(strpool_t handle);
+uint32_t strpool_used(void);
+void strpool_release(uint32_t used);
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+#if STRPOOL_SIZE > 0xFFFF
+#error "STRPOOL_SIZE must fit in a handle"
+#endif
+
+#endif
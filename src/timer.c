@@ -6,6 +6,8 @@
 
 #include "chip.h"
 #include "timer.h"
+#include "prof.h"
+#include "sched.h"
 
 
 /*
@@ -35,7 +37,7 @@
 ****************************************************************************************************
 */
 
-void (*g_callback)(void);
+static void (*g_callback)(void);
 
 
 /*
@@ -75,13 +77,16 @@ void timer_set(uint32_t time_us)
 
     // timer rate is system clock rate
     uint32_t timer_freq = Chip_Clock_GetSystemClockRate();
-    Chip_TIMER_SetMatch(LPC_TIMER32_0, 1, timer_freq / (1000000 / time_us));
+    Chip_TIMER_SetMatch(LPC_TIMER32_0, 1, (timer_freq / 1000000) * time_us);
 
     Chip_TIMER_Enable(LPC_TIMER32_0);
 }
 
 void TIMER32_0_IRQHandler(void)
 {
+    sched_irq_entry();
+    PROF_ENTER(PROF_TIMER);
+
     if (Chip_TIMER_MatchPending(LPC_TIMER32_0, 1))
     {
         Chip_TIMER_ClearMatch(LPC_TIMER32_0, 1);
@@ -90,4 +95,6 @@ void TIMER32_0_IRQHandler(void)
         if (g_callback)
             g_callback();
     }
+
+    PROF_EXIT(PROF_TIMER);
 }
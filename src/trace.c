@@ -0,0 +1,134 @@
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include "trace.h"
+#include "hardware.h"
+
+#ifdef TRACE
+
+/*
+****************************************************************************************************
+*       INTERNAL MACROS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL CONSTANTS
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       INTERNAL DATA TYPES
+****************************************************************************************************
+*/
+
+typedef struct trace_t {
+    uint16_t head, count;
+    uint16_t last_time;
+    int8_t last_direction;
+    uint8_t frozen;
+} trace_t;
+
+
+/*
+****************************************************************************************************
+*       INTERNAL GLOBAL VARIABLES
+****************************************************************************************************
+*/
+
+static uint8_t g_buffer[TRACE_BUFFER_SIZE] USB_RAM;
+static trace_t g_trace = {.last_direction = -1};
+
+
+/*
+****************************************************************************************************
+*       INTERNAL FUNCTIONS
+****************************************************************************************************
+*/
+
+static inline void put(uint8_t byte)
+{
+    g_buffer[g_trace.head] = byte;
+
+    if (++g_trace.head == TRACE_BUFFER_SIZE)
+        g_trace.head = 0;
+
+    if (g_trace.count < TRACE_BUFFER_SIZE)
+        g_trace.count++;
+}
+
+
+/*
+****************************************************************************************************
+*       GLOBAL FUNCTIONS
+****************************************************************************************************
+*/
+
+// must be called with the uart interrupt disabled or from the uart interrupt
+void trace_record(int direction, const uint8_t *data, uint32_t size)
+{
+    if (g_trace.frozen)
+        return;
+
+    uint16_t now = hw_uptime();
+    if (now != g_trace.last_time || direction != g_trace.last_direction)
+    {
+        put(TRACE_ESCAPE);
+        put(TRACE_MARKER | direction);
+        put(now & 0xFF);
+        put(now >> 8);
+
+        g_trace.last_time = now;
+        g_trace.last_direction = direction;
+    }
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        put(data[i]);
+
+        if (data[i] == TRACE_ESCAPE)
+            put(0x00);
+    }
+}
+
+void trace_freeze(void)
+{
+    g_trace.frozen = 1;
+}
+
+int trace_frozen(void)
+{
+    return g_trace.frozen;
+}
+
+// writes the header followed by the buffer content from the oldest to the newest byte
+void trace_dump(void (*write_cb)(const uint8_t *data, uint32_t size))
+{
+    uint8_t header[8] = TRACE_MAGIC;
+    uint16_t tail = (g_trace.head + TRACE_BUFFER_SIZE - g_trace.count) % TRACE_BUFFER_SIZE;
+
+    header[4] = g_trace.count & 0xFF;
+    header[5] = g_trace.count >> 8;
+    header[6] = TRACE_BUFFER_SIZE & 0xFF;
+    header[7] = TRACE_BUFFER_SIZE >> 8;
+    write_cb(header, sizeof(header));
+
+    if (tail + g_trace.count > TRACE_BUFFER_SIZE)
+    {
+        write_cb(&g_buffer[tail], TRACE_BUFFER_SIZE - tail);
+        write_cb(g_buffer, g_trace.head);
+    }
+    else
+    {
+        write_cb(&g_buffer[tail], g_trace.count);
+    }
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+****************************************************************************************************
+*       INCLUDE FILES
+****************************************************************************************************
+*/
+
+#include <stdint.h>
+
+
+/*
+****************************************************************************************************
+*       MACROS
+****************************************************************************************************
+*/
+
+enum {TRACE_RX, TRACE_TX};
+
+// trace file header
+#define TRACE_MAGIC         "CCTR"
+
+// escape byte of the trace stream
+// 0xFF 0x00 is a literal 0xFF
+// 0xFF (0x80 | direction) time_lo time_hi marks a new direction or millisecond
+#define TRACE_ESCAPE        0xFF
+#define TRACE_MARKER        0x80
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION
+****************************************************************************************************
+*/
+
+// size of the trace buffer in bytes (placed in the USB RAM)
+#define TRACE_BUFFER_SIZE   1536
+
+
+/*
+****************************************************************************************************
+*       DATA TYPES
+****************************************************************************************************
+*/
+
+
+/*
+****************************************************************************************************
+*       FUNCTION PROTOTYPES
+****************************************************************************************************
+*/
+
+#ifdef TRACE
+void trace_record(int direction, const uint8_t *data, uint32_t size);
+void trace_freeze(void);
+int trace_frozen(void);
+void trace_dump(void (*write_cb)(const uint8_t *data, uint32_t size));
+#else
+#define trace_record(direction, data, size) ((void) 0)
+#define trace_freeze() ((void) 0)
+#define trace_frozen()      0
+#define trace_dump(write_cb) ((void) 0)
+#endif
+
+
+/*
+****************************************************************************************************
+*       CONFIGURATION ERRORS
+****************************************************************************************************
+*/
+
+
+#endif
@@ -71,6 +71,7 @@ static char* reverse(char* str, uint32_t str_len)
 ****************************************************************************************************
 */
 
+#ifndef INTEGER_ONLY
 uint32_t float_to_str(float num, char *string, uint32_t string_size, uint8_t precision)
 {
     int p = 1;
@@ -101,6 +102,35 @@ uint32_t float_to_str(float num, char *string, uint32_t string_size, uint8_t pre
     if (len < string_size) len += int_to_str(decimal_part, string, string_size - len, precision, 0);
     return len;
 }
+#endif
+
+// same as float_to_str for a number given in thousandths (precision up to 3)
+uint32_t milli_to_str(int32_t num, char *string, uint32_t string_size, uint8_t precision)
+{
+    int32_t p = 1;
+    int i = 0;
+    while (i < precision) {
+        p *= 10;
+        i++;
+    }
+    int32_t divider = 1000 / p;
+    uint32_t len = 0;
+    uint8_t need_minus = 0;
+    if (num >= 0) {
+        num = (num + divider / 2) / divider;
+    } else {
+        num = (num - divider / 2) / divider;
+        need_minus = 1;
+    }
+    int32_t int_part = num / p;
+    int32_t decimal_part = (num < 0 ? -(num % p) : num % p);
+    len += int_to_str(int_part, string, string_size, 0, need_minus);
+    while (*string != '\0') string++;
+    *string++ = '.';
+    len++;
+    if (len < string_size) len += int_to_str(decimal_part, string, string_size - len, precision, 0);
+    return len;
+}
 
 uint32_t int_to_str(int32_t num, char *string, uint32_t string_size, uint8_t zero_leading, uint8_t need_minus)
 {
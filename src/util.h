@@ -37,7 +37,10 @@
 */
 
 uint32_t int_to_str(int32_t num, char *string, uint32_t string_size, uint8_t zero_leading, uint8_t need_minus);
+#ifndef INTEGER_ONLY
 uint32_t float_to_str(float num, char *string, uint32_t string_size, uint8_t precision);
+#endif
+uint32_t milli_to_str(int32_t num, char *string, uint32_t string_size, uint8_t precision);
 
 
 /*
@@ -0,0 +1,39 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "baud.h"
+
+// uart clock of the footswitch (main clock, uart clock divider = 1)
+#define UART_CLOCK  48000000
+
+static const uint32_t rates[] = {
+    9600, 19200, 38400, 57600, 115200, 230400, 250000, 460800,
+    500000, 750000, 921600, 1000000, 1500000, 2000000, 3000000
+};
+
+int main(int argc, char **argv)
+{
+    uint32_t clock = (argc > 1 ? strtoul(argv[1], NULL, 0) : UART_CLOCK);
+
+    printf("uart clock: %u Hz\n\n", clock);
+    printf("| requested | actual  | DL    | DIVADDVAL | MULVAL | error   | usable |\n");
+    printf("|-----------|---------|-------|-----------|--------|---------|--------|\n");
+
+    for (unsigned int i = 0; i < sizeof(rates)/sizeof(rates[0]); i++)
+    {
+        baud_divider_t divider;
+        uint32_t actual = baud_divider_calc(clock, rates[i], &divider);
+
+        if (actual == 0)
+        {
+            printf("| %9u | -       | -     | -         | -      | -       | no     |\n", rates[i]);
+            continue;
+        }
+
+        uint32_t error = baud_error_ppm(rates[i], actual);
+        printf("| %9u | %7u | %5u | %9u | %6u | %6.3f%% | %-6s |\n",
+            rates[i], actual, divider.dl, divider.divaddval, divider.mulval,
+            error / 10000.0, error <= BAUD_MAX_ERROR_PPM ? "yes" : "no");
+    }
+
+    return 0;
+}
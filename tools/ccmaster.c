@@ -0,0 +1,695 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// control chain master stand-in for throughput and soak tests
+// usage: ccmaster [options] port
+// the port is the pty of the simulator (make sim) or a serial adapter on the bus
+//
+// the master side runs the handshake, reads the device descriptor and assigns every
+// actuator, then for --duration seconds floods assignments (--assign) and fires random
+// set value commands (--set-rate) while counting the data updates of the device. the
+// round trip of each request goes until the device answers with the same command
+
+// protocol: sync byte, header (address, command, data size), header crc, data, data crc
+// the layout follows the cc-slave library the firmware is built with (src/cc-slave)
+#define CC_SYNC_BYTE            0xA7
+#define CC_BROADCAST_ADDRESS    0
+#define CC_HEADER_SIZE          4
+#define CC_MAX_DATA_SIZE        1024
+
+enum {CC_CMD_CHAIN_SYNC, CC_CMD_HANDSHAKE, CC_CMD_DEV_CONTROL, CC_CMD_DEV_DESCRIPTOR,
+      CC_CMD_ASSIGNMENT, CC_CMD_DATA_UPDATE, CC_CMD_UNASSIGNMENT, CC_CMD_SET_VALUE, CC_CMD_COUNT};
+enum {CC_SYNC_SETUP_CYCLE, CC_SYNC_REGULAR_CYCLE, CC_SYNC_HANDSHAKE_CYCLE};
+enum {CC_HANDSHAKE_OK};
+
+#define CC_MODE_TOGGLE          0x01
+
+#define DEVICE_ADDRESS          1
+#define MAX_PENDING             256
+#define DEFAULT_ACTUATORS       4
+
+static const char *command_name[CC_CMD_COUNT] = {
+    "sync", "handshake", "control", "descriptor", "assignment", "update", "unassignment", "set value",
+};
+
+typedef struct rtt_stats_t {
+    uint32_t requests, answered, dropped, late;
+    uint32_t *rtt_us, size;
+} rtt_stats_t;
+
+typedef struct pending_t {
+    uint8_t command;
+    uint64_t sent_us;
+} pending_t;
+
+static struct {
+    const char *port;
+    uint32_t baud_rate;
+    double duration, set_rate;
+    uint32_t assign, window, sync_ms, late_ms, timeout_ms, seed;
+    const char *report;
+} g_options = {
+    .baud_rate = 115200, .duration = 10.0, .window = 1, .sync_ms = 2, .late_ms = 20,
+    .timeout_ms = 200, .seed = 1,
+};
+
+static int g_fd;
+static uint64_t g_start_us;
+
+static rtt_stats_t g_stats[CC_CMD_COUNT];
+static pending_t g_pending[MAX_PENDING];
+static int g_pending_first, g_pending_count;
+
+static uint32_t g_frames_sent, g_frames_received, g_bad_frames, g_updates;
+static uint64_t g_bytes_sent, g_bytes_received;
+
+static int g_handshake_done, g_descriptor_done;
+static uint64_t g_handshake_us;
+static char g_device_label[64];
+static int g_actuators = DEFAULT_ACTUATORS;
+static uint32_t g_assignment_id;
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static uint8_t crc8(const uint8_t *data, uint32_t size)
+{
+    uint8_t crc = 0;
+
+    while (size--)
+    {
+        uint8_t byte = *data++;
+        for (int i = 0; i < 8; i++)
+        {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix)
+                crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+
+    return crc;
+}
+
+// frames
+
+static void write_all(const uint8_t *data, uint32_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(g_fd, data, size);
+        if (written < 0)
+        {
+            if (errno != EAGAIN && errno != EINTR)
+            {
+                perror("write");
+                exit(1);
+            }
+
+            struct pollfd pfd = {.fd = g_fd, .events = POLLOUT};
+            poll(&pfd, 1, 10);
+            continue;
+        }
+
+        data += written;
+        size -= written;
+    }
+}
+
+static void send_frame(uint8_t address, uint8_t command, const uint8_t *data, uint16_t size)
+{
+    uint8_t frame[1 + CC_HEADER_SIZE + 1 + CC_MAX_DATA_SIZE + 1];
+    uint32_t i = 0;
+
+    frame[i++] = CC_SYNC_BYTE;
+    frame[i++] = address;
+    frame[i++] = command;
+    frame[i++] = size & 0xFF;
+    frame[i++] = size >> 8;
+    frame[i] = crc8(&frame[1], CC_HEADER_SIZE);
+    i++;
+
+    if (size > 0)
+    {
+        memcpy(&frame[i], data, size);
+        i += size;
+        frame[i++] = crc8(data, size);
+    }
+
+    write_all(frame, i);
+    g_frames_sent++;
+    g_bytes_sent += i;
+}
+
+// requests are answered in order, the answer has the same command
+static void send_request(uint8_t command, const uint8_t *data, uint16_t size)
+{
+    if (g_pending_count >= MAX_PENDING)
+        return;
+
+    pending_t *pending = &g_pending[(g_pending_first + g_pending_count++) % MAX_PENDING];
+    pending->command = command;
+    pending->sent_us = now_us();
+    g_stats[command].requests++;
+
+    send_frame(DEVICE_ADDRESS, command, data, size);
+}
+
+static int pending_of(uint8_t command)
+{
+    int count = 0;
+
+    for (int i = 0; i < g_pending_count; i++)
+    {
+        if (g_pending[(g_pending_first + i) % MAX_PENDING].command == command)
+            count++;
+    }
+
+    return count;
+}
+
+static void pending_remove(int index)
+{
+    for (int i = index; i > 0; i--)
+        g_pending[(g_pending_first + i) % MAX_PENDING] = g_pending[(g_pending_first + i - 1) % MAX_PENDING];
+
+    g_pending_first = (g_pending_first + 1) % MAX_PENDING;
+    g_pending_count--;
+}
+
+static void answered(uint8_t command)
+{
+    for (int i = 0; i < g_pending_count; i++)
+    {
+        pending_t *pending = &g_pending[(g_pending_first + i) % MAX_PENDING];
+        if (pending->command != command)
+            continue;
+
+        rtt_stats_t *stats = &g_stats[command];
+        uint32_t rtt_us = now_us() - pending->sent_us;
+
+        stats->rtt_us = realloc(stats->rtt_us, (stats->answered + 1) * sizeof(uint32_t));
+        stats->rtt_us[stats->answered++] = rtt_us;
+
+        if (rtt_us > g_options.late_ms * 1000)
+            stats->late++;
+
+        pending_remove(i);
+        return;
+    }
+}
+
+// requests without answer after the timeout are dropped
+static void expire(void)
+{
+    uint64_t now = now_us();
+
+    for (int i = 0; i < g_pending_count; )
+    {
+        pending_t *pending = &g_pending[(g_pending_first + i) % MAX_PENDING];
+        if (now - pending->sent_us > g_options.timeout_ms * 1000)
+        {
+            g_stats[pending->command].dropped++;
+            pending_remove(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+static void put_float(uint8_t *data, float value)
+{
+    memcpy(data, &value, sizeof(float));
+}
+
+static int put_str(uint8_t *data, const char *text)
+{
+    int size = strlen(text);
+    if (size > 16)
+        size = 16;
+
+    data[0] = size;
+    memcpy(&data[1], text, size);
+
+    return size + 1;
+}
+
+// master flows
+
+static void send_sync(void)
+{
+    uint8_t cycle = (g_handshake_done ? CC_SYNC_REGULAR_CYCLE : CC_SYNC_HANDSHAKE_CYCLE);
+    send_frame(CC_BROADCAST_ADDRESS, CC_CMD_CHAIN_SYNC, &cycle, 1);
+}
+
+static void send_assignment(int actuator)
+{
+    uint8_t data[64];
+    int i = 0;
+    char label[17];
+
+    snprintf(label, sizeof(label), "CC #%u", g_assignment_id % 1000);
+
+    data[i++] = actuator;
+    data[i++] = actuator;
+    i += put_str(&data[i], label);
+    put_float(&data[i], 0.0f); i += 4;      // value
+    put_float(&data[i], 0.0f); i += 4;      // minimum
+    put_float(&data[i], 1.0f); i += 4;      // maximum
+    put_float(&data[i], 0.0f); i += 4;      // default
+    data[i++] = CC_MODE_TOGGLE;
+    data[i++] = 0;
+    data[i++] = 0;
+    data[i++] = 0;
+    data[i++] = 0;                          // steps
+    data[i++] = 0;
+    i += put_str(&data[i], "");             // unit
+    data[i++] = 0;                          // list count
+
+    g_assignment_id++;
+    send_request(CC_CMD_ASSIGNMENT, data, i);
+}
+
+static void send_set_value(int actuator)
+{
+    uint8_t data[6];
+
+    data[0] = actuator;
+    data[1] = actuator;
+    put_float(&data[2], rand() & 1);
+
+    send_request(CC_CMD_SET_VALUE, data, sizeof(data));
+}
+
+static void handle_frame(uint8_t address, uint8_t command, const uint8_t *data, uint16_t size)
+{
+    (void) address;
+
+    if (command == CC_CMD_HANDSHAKE && size >= 2)
+    {
+        // random id of the device, the status and the address it gets
+        uint8_t reply[5] = {data[0], data[1], CC_HANDSHAKE_OK, DEVICE_ADDRESS, 0};
+        send_frame(CC_BROADCAST_ADDRESS, CC_CMD_HANDSHAKE, reply, sizeof(reply));
+
+        if (!g_handshake_done)
+        {
+            g_handshake_done = 1;
+            g_handshake_us = now_us() - g_start_us;
+            send_request(CC_CMD_DEV_DESCRIPTOR, 0, 0);
+        }
+    }
+    else if (command == CC_CMD_DEV_DESCRIPTOR)
+    {
+        answered(command);
+
+        // label and number of actuators lead the descriptor
+        if (size >= 1 && data[0] < sizeof(g_device_label) && 1 + data[0] < size)
+        {
+            memcpy(g_device_label, &data[1], data[0]);
+            g_device_label[data[0]] = 0;
+
+            int count = data[1 + data[0]];
+            if (count > 0 && count <= 255)
+                g_actuators = count;
+        }
+
+        g_descriptor_done = 1;
+    }
+    else if (command == CC_CMD_DATA_UPDATE)
+    {
+        g_updates += (size >= 1 ? data[0] : 0);
+    }
+    else if (command < CC_CMD_COUNT)
+    {
+        answered(command);
+    }
+}
+
+static void parse(const uint8_t *buffer, uint32_t size)
+{
+    enum {SYNC, HEADER, HEADER_CRC, DATA, DATA_CRC};
+    static int state = SYNC;
+    static uint8_t header[CC_HEADER_SIZE], data[CC_MAX_DATA_SIZE];
+    static uint32_t index, data_size;
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        uint8_t byte = buffer[i];
+
+        switch (state)
+        {
+            case SYNC:
+                if (byte == CC_SYNC_BYTE)
+                {
+                    state = HEADER;
+                    index = 0;
+                }
+                break;
+
+            case HEADER:
+                header[index++] = byte;
+                if (index == CC_HEADER_SIZE)
+                    state = HEADER_CRC;
+                break;
+
+            case HEADER_CRC:
+                data_size = header[2] | (header[3] << 8);
+                if (byte != crc8(header, CC_HEADER_SIZE) || data_size > CC_MAX_DATA_SIZE)
+                {
+                    g_bad_frames++;
+                    state = SYNC;
+                }
+                else if (data_size == 0)
+                {
+                    g_frames_received++;
+                    handle_frame(header[0], header[1], data, 0);
+                    state = SYNC;
+                }
+                else
+                {
+                    index = 0;
+                    state = DATA;
+                }
+                break;
+
+            case DATA:
+                data[index++] = byte;
+                if (index == data_size)
+                    state = DATA_CRC;
+                break;
+
+            case DATA_CRC:
+                if (byte != crc8(data, data_size))
+                {
+                    g_bad_frames++;
+                }
+                else
+                {
+                    g_frames_received++;
+                    handle_frame(header[0], header[1], data, data_size);
+                }
+                state = SYNC;
+                break;
+        }
+    }
+}
+
+// report
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+// nearest rank, in milliseconds
+static double percentile(const rtt_stats_t *stats, double p)
+{
+    if (stats->answered == 0)
+        return 0.0;
+
+    uint32_t rank = (p * stats->answered + 99) / 100;
+    if (rank < 1)
+        rank = 1;
+
+    return stats->rtt_us[rank - 1] / 1000.0;
+}
+
+static void report(double elapsed)
+{
+    static const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 100.0};
+    static const char *percentile_names[] = {"p50", "p90", "p99", "p99.9", "max"};
+    FILE *fp = (g_options.report ? fopen(g_options.report, "w") : 0);
+
+    if (g_options.report && !fp)
+        perror(g_options.report);
+
+    printf("device: %s, %d actuators, handshake after %.1f ms\n",
+        g_device_label[0] ? g_device_label : "?", g_actuators, g_handshake_us / 1000.0);
+    printf("frames: %u sent (%.1f/s, %.0f B/s), %u received (%.1f/s, %.0f B/s), %u bad\n",
+        g_frames_sent, g_frames_sent / elapsed, g_bytes_sent / elapsed,
+        g_frames_received, g_frames_received / elapsed, g_bytes_received / elapsed, g_bad_frames);
+    printf("updates: %u actuator values (%.1f/s)\n\n", g_updates, g_updates / elapsed);
+
+    printf("%-12s %8s %8s %8s %8s", "request", "sent", "answered", "dropped", "late");
+    for (unsigned int i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++)
+        printf(" %8s", percentile_names[i]);
+    printf("  (ms)\n");
+
+    for (int command = 0; command < CC_CMD_COUNT; command++)
+    {
+        rtt_stats_t *stats = &g_stats[command];
+        if (stats->requests == 0)
+            continue;
+
+        qsort(stats->rtt_us, stats->answered, sizeof(uint32_t), compare_u32);
+
+        printf("%-12s %8u %8u %8u %8u", command_name[command],
+            stats->requests, stats->answered, stats->dropped, stats->late);
+        for (unsigned int i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++)
+            printf(" %8.2f", percentile(stats, percentiles[i]));
+        printf("\n");
+
+        // one value per line for regression tracking
+        if (fp)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "%s", command_name[command]);
+            for (char *c = name; *c; c++)
+                *c = (*c == ' ' ? '_' : *c);
+
+            fprintf(fp, "%s.sent %u\n%s.dropped %u\n%s.late %u\n", name, stats->requests,
+                name, stats->dropped, name, stats->late);
+            for (unsigned int i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++)
+                fprintf(fp, "%s.%s_ms %.3f\n", name, percentile_names[i], percentile(stats, percentiles[i]));
+        }
+    }
+
+    if (fp)
+    {
+        fprintf(fp, "frames.sent_per_s %.1f\nframes.received_per_s %.1f\nframes.bad %u\n",
+            g_frames_sent / elapsed, g_frames_received / elapsed, g_bad_frames);
+        fclose(fp);
+    }
+}
+
+static speed_t baud_constant(uint32_t baud_rate)
+{
+    switch (baud_rate)
+    {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 500000: return B500000;
+        case 921600: return B921600;
+        case 1000000: return B1000000;
+        case 1500000: return B1500000;
+        case 3000000: return B3000000;
+    }
+
+    return 0;
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+        "usage: %s [options] port\n"
+        "  --baud N         baud rate of a serial adapter (default 115200)\n"
+        "  --duration S     length of the test after the setup (default 10)\n"
+        "  --assign N       assignments flooded during the test\n"
+        "  --window N       requests in flight of the assignment flood (default 1)\n"
+        "  --set-rate N     random set value commands per second\n"
+        "  --sync MS        chain sync period (default 2)\n"
+        "  --late MS        answers slower than this are late (default 20)\n"
+        "  --timeout MS     requests not answered in this time are dropped (default 200)\n"
+        "  --seed N         seed of the random commands (default 1)\n"
+        "  --report FILE    writes the results as name value lines\n", program);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc ? argv[i + 1] : 0);
+
+        if (arg[0] != '-')
+        {
+            g_options.port = arg;
+            continue;
+        }
+
+        if (!value)
+            usage(argv[0]);
+        else if (!strcmp(arg, "--baud"))
+            g_options.baud_rate = atoi(value);
+        else if (!strcmp(arg, "--duration"))
+            g_options.duration = atof(value);
+        else if (!strcmp(arg, "--assign"))
+            g_options.assign = atoi(value);
+        else if (!strcmp(arg, "--window"))
+            g_options.window = atoi(value);
+        else if (!strcmp(arg, "--set-rate"))
+            g_options.set_rate = atof(value);
+        else if (!strcmp(arg, "--sync"))
+            g_options.sync_ms = atoi(value);
+        else if (!strcmp(arg, "--late"))
+            g_options.late_ms = atoi(value);
+        else if (!strcmp(arg, "--timeout"))
+            g_options.timeout_ms = atoi(value);
+        else if (!strcmp(arg, "--seed"))
+            g_options.seed = atoi(value);
+        else if (!strcmp(arg, "--report"))
+            g_options.report = value;
+        else
+            usage(argv[0]);
+
+        i++;
+    }
+
+    if (!g_options.port || g_options.window == 0 || g_options.sync_ms == 0)
+        usage(argv[0]);
+
+    g_fd = open(g_options.port, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (g_fd < 0)
+    {
+        perror(g_options.port);
+        return 1;
+    }
+
+    struct termios tio;
+    if (tcgetattr(g_fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        if (baud_constant(g_options.baud_rate))
+            cfsetspeed(&tio, baud_constant(g_options.baud_rate));
+        tcsetattr(g_fd, TCSANOW, &tio);
+    }
+
+    srand(g_options.seed);
+    g_start_us = now_us();
+
+    uint64_t next_sync = g_start_us, next_set = 0, test_start = 0, test_end = 0;
+    uint32_t flooded = 0;
+    int setup_assigned = 0;
+
+    while (!test_end || now_us() < test_end)
+    {
+        uint64_t now = now_us();
+
+        if (now >= next_sync)
+        {
+            send_sync();
+            next_sync += g_options.sync_ms * 1000;
+            if (next_sync < now)
+                next_sync = now + g_options.sync_ms * 1000;
+        }
+
+        // setup: handshake, descriptor and one assignment per actuator
+        if (!g_handshake_done && now - g_start_us > 5000000)
+        {
+            fprintf(stderr, "no handshake from the device\n");
+            return 1;
+        }
+
+        if (g_descriptor_done && !setup_assigned)
+        {
+            for (int actuator = 0; actuator < g_actuators; actuator++)
+                send_assignment(actuator);
+
+            setup_assigned = 1;
+        }
+
+        if (setup_assigned && !test_start && pending_of(CC_CMD_ASSIGNMENT) == 0)
+        {
+            test_start = now;
+            test_end = now + (uint64_t) (g_options.duration * 1000000);
+            next_set = now;
+        }
+
+        // test: assignment flood and set value storm
+        if (test_start)
+        {
+            while (flooded < g_options.assign && (uint32_t) pending_of(CC_CMD_ASSIGNMENT) < g_options.window)
+                send_assignment(flooded++ % g_actuators);
+
+            if (g_options.set_rate > 0 && now >= next_set)
+            {
+                send_set_value(rand() % g_actuators);
+
+                // random intervals with the requested mean
+                double interval = (2.0 * rand() / RAND_MAX) * 1000000.0 / g_options.set_rate;
+                next_set += (uint64_t) interval;
+            }
+        }
+
+        expire();
+
+        // waits for the device until the next sync
+        now = now_us();
+        int timeout_ms = (next_sync > now ? (next_sync - now + 999) / 1000 : 0);
+        struct pollfd pfd = {.fd = g_fd, .events = POLLIN};
+        if (poll(&pfd, 1, timeout_ms) > 0 && (pfd.revents & POLLIN))
+        {
+            uint8_t buffer[256];
+            ssize_t size = read(g_fd, buffer, sizeof(buffer));
+            if (size > 0)
+            {
+                g_bytes_received += size;
+                parse(buffer, size);
+            }
+        }
+    }
+
+    // late answers still count
+    uint64_t drain_end = now_us() + g_options.timeout_ms * 1000;
+    while (g_pending_count > 0 && now_us() < drain_end)
+    {
+        struct pollfd pfd = {.fd = g_fd, .events = POLLIN};
+        if (poll(&pfd, 1, g_options.sync_ms) > 0 && (pfd.revents & POLLIN))
+        {
+            uint8_t buffer[256];
+            ssize_t size = read(g_fd, buffer, sizeof(buffer));
+            if (size > 0)
+            {
+                g_bytes_received += size;
+                parse(buffer, size);
+            }
+        }
+
+        send_sync();
+        expire();
+    }
+
+    while (g_pending_count > 0)
+    {
+        g_stats[g_pending[g_pending_first].command].dropped++;
+        pending_remove(0);
+    }
+
+    report((now_us() - test_start) / 1000000.0);
+    close(g_fd);
+
+    return 0;
+}
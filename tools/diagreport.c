@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "diag.h"
+
+// prints the counters of the diagnostic dump of a firmware built with DIAG=1 (or TRACE, LATENCY or
+// PROFILE), one per line
+// usage: diagreport capture.bin
+// the capture can have other bytes (e.g. a wire trace) before the dump header
+
+#define COUNTER_SIZE    (DIAG_NAME_SIZE + 4)
+
+static uint32_t get_u32(const uint8_t *buffer)
+{
+    return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((uint32_t) buffer[3] << 24);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s capture.bin\n", argv[0]);
+        return 1;
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (!fp)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    uint8_t *file = malloc(file_size);
+    if (!file || fread(file, 1, file_size, fp) != (size_t) file_size)
+    {
+        fprintf(stderr, "can't read %s\n", argv[1]);
+        return 1;
+    }
+    fclose(fp);
+
+    // the last dump of the capture is the most recent
+    long pos = -1;
+    for (long i = 0; i + 8 <= file_size; i++)
+    {
+        if (memcmp(&file[i], DIAG_MAGIC, 4) == 0)
+            pos = i;
+    }
+
+    if (pos < 0)
+    {
+        fprintf(stderr, "diagnostic header not found\n");
+        return 1;
+    }
+
+    printf("uptime: %u ms\n\n", get_u32(&file[pos + 4]));
+
+    uint32_t counters = 0;
+    for (pos += 8; pos + COUNTER_SIZE <= file_size; pos += COUNTER_SIZE)
+    {
+        const uint8_t *c = &file[pos];
+
+        char name[DIAG_NAME_SIZE + 1];
+        memcpy(name, c, DIAG_NAME_SIZE);
+        name[DIAG_NAME_SIZE] = 0;
+
+        // the end of the dump has the number of counters
+        if (name[0] == 0)
+        {
+            if (get_u32(&c[DIAG_NAME_SIZE]) != counters)
+            {
+                fprintf(stderr, "diagnostic dump has %u counters, %u expected\n", counters,
+                    get_u32(&c[DIAG_NAME_SIZE]));
+                return 1;
+            }
+
+            free(file);
+            return 0;
+        }
+
+        printf("%-8s %10u\n", name, get_u32(&c[DIAG_NAME_SIZE]));
+        counters++;
+    }
+
+    fprintf(stderr, "diagnostic dump truncated\n");
+    return 1;
+}
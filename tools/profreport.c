@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "prof.h"
+
+// pretty-prints the profiler dump of a firmware built with PROFILE=1
+// usage: profreport capture.bin
+// the capture can have other bytes (e.g. a wire trace) before the profiler header
+// the cycles of a region exclude the regions entered inside it, so the percentages add up
+
+#define NAME_SIZE       8
+#define REGION_SIZE     (NAME_SIZE + 5*4)
+
+static uint32_t get_u32(const uint8_t *buffer)
+{
+    return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((uint32_t) buffer[3] << 24);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s capture.bin\n", argv[0]);
+        return 1;
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (!fp)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    uint8_t *file = malloc(file_size);
+    if (!file || fread(file, 1, file_size, fp) != (size_t) file_size)
+    {
+        fprintf(stderr, "can't read %s\n", argv[1]);
+        return 1;
+    }
+    fclose(fp);
+
+    // the last dump of the capture is the most recent
+    long pos = -1;
+    for (long i = 0; i + 16 <= file_size; i++)
+    {
+        if (memcmp(&file[i], PROF_MAGIC, 4) == 0)
+            pos = i;
+    }
+
+    if (pos < 0)
+    {
+        fprintf(stderr, "profiler header not found\n");
+        return 1;
+    }
+
+    uint32_t regions = get_u32(&file[pos + 4]);
+    uint32_t cycles_per_ms = get_u32(&file[pos + 8]);
+    uint32_t uptime_ms = get_u32(&file[pos + 12]);
+    const uint8_t *data = &file[pos + 16];
+
+    if (pos + 16 + regions * REGION_SIZE > (uint32_t) file_size || cycles_per_ms == 0)
+    {
+        fprintf(stderr, "profiler dump truncated\n");
+        return 1;
+    }
+
+    double cycles_per_us = cycles_per_ms / 1000.0;
+    double elapsed = (double) uptime_ms * cycles_per_ms;
+
+    printf("uptime: %u ms, %u cycles/ms\n\n", uptime_ms, cycles_per_ms);
+    printf("%-8s %10s %10s %10s %10s %10s %8s\n",
+        "region", "calls", "min (cyc)", "avg (cyc)", "max (cyc)", "max (us)", "time %");
+
+    for (uint32_t i = 0; i < regions; i++)
+    {
+        const uint8_t *r = &data[i * REGION_SIZE];
+
+        char name[NAME_SIZE + 1];
+        memcpy(name, r, NAME_SIZE);
+        name[NAME_SIZE] = 0;
+
+        uint32_t calls = get_u32(&r[NAME_SIZE + 0]);
+        uint32_t min = get_u32(&r[NAME_SIZE + 4]);
+        uint32_t max = get_u32(&r[NAME_SIZE + 8]);
+        uint64_t total = get_u32(&r[NAME_SIZE + 12]) | ((uint64_t) get_u32(&r[NAME_SIZE + 16]) << 32);
+
+        if (calls == 0)
+        {
+            printf("%-8s %10u %10s %10s %10s %10s %8s\n", name, 0, "-", "-", "-", "-", "-");
+            continue;
+        }
+
+        printf("%-8s %10u %10u %10llu %10u %10.1f %7.2f%%\n", name, calls, min,
+            (unsigned long long) (total / calls), max, max / cycles_per_us,
+            elapsed > 0 ? (100.0 * total / elapsed) : 0.0);
+    }
+
+    free(file);
+    return 0;
+}
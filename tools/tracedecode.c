@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "trace.h"
+
+// decodes a wire trace dumped by a firmware built with TRACE=1
+// usage: tracedecode capture.bin
+// the capture can have other bytes before the trace header
+
+#define BYTES_PER_LINE  16
+
+static const char *dir_name[] = {"RX", "TX"};
+
+static void print_line(uint32_t time, int direction, const uint8_t *data, int size, int first)
+{
+    if (first)
+        printf("%10u  %s ", time, dir_name[direction]);
+    else
+        printf("%10s  %s ", "", "  ");
+
+    for (int i = 0; i < size; i++)
+        printf(" %02x", data[i]);
+
+    printf("\n");
+}
+
+// a marker is the escape byte followed by the marker flag and a direction
+static int is_marker(const uint8_t *data, uint32_t i, uint32_t count)
+{
+    return (i + 3 < count && data[i] == TRACE_ESCAPE &&
+        (data[i + 1] == (TRACE_MARKER | 0) || data[i + 1] == (TRACE_MARKER | 1)));
+}
+
+// the stream from a candidate marker to the end must be one the firmware writes: every escape byte
+// is a literal or a marker, and each marker changes the direction or moves the time forward
+static int stream_valid(const uint8_t *data, uint32_t i, uint32_t count)
+{
+    int direction = -1;
+    uint16_t time = 0;
+
+    while (i < count)
+    {
+        if (data[i] != TRACE_ESCAPE)
+        {
+            i++;
+            continue;
+        }
+
+        // the last bytes may be an escape the buffer cut
+        if (i + 1 == count)
+            return 1;
+
+        if (data[i + 1] == 0x00)
+        {
+            i += 2;
+            continue;
+        }
+
+        if (!is_marker(data, i, count))
+            return (i + 3 >= count && (data[i + 1] & ~1) == TRACE_MARKER);
+
+        uint16_t raw = data[i + 2] | (data[i + 3] << 8);
+        int next = data[i + 1] & 1;
+
+        if (direction >= 0 && ((raw == time && next == direction) || (uint16_t) (raw - time) >= 0x8000))
+            return 0;
+
+        direction = next;
+        time = raw;
+        i += 4;
+    }
+
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s capture.bin\n", argv[0]);
+        return 1;
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (!fp)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    uint8_t *file = malloc(file_size);
+    if (!file || fread(file, 1, file_size, fp) != (size_t) file_size)
+    {
+        fprintf(stderr, "can't read %s\n", argv[1]);
+        return 1;
+    }
+    fclose(fp);
+
+    // find the header
+    long pos;
+    for (pos = 0; pos + 8 <= file_size; pos++)
+    {
+        if (memcmp(&file[pos], TRACE_MAGIC, 4) == 0)
+            break;
+    }
+
+    if (pos + 8 > file_size)
+    {
+        fprintf(stderr, "trace header not found\n");
+        return 1;
+    }
+
+    uint32_t count = file[pos + 4] | (file[pos + 5] << 8);
+    uint32_t buffer_size = file[pos + 6] | (file[pos + 7] << 8);
+    const uint8_t *data = &file[pos + 8];
+
+    if (pos + 8 + count > (uint32_t) file_size)
+    {
+        fprintf(stderr, "trace truncated: %ld of %u bytes\n", file_size - pos - 8, count);
+        count = file_size - pos - 8;
+    }
+
+    printf("trace: %u of %u bytes\n", count, buffer_size);
+    printf("%10s  %s  %s\n", "time (ms)", "dir", "data");
+
+    uint32_t i = 0;
+
+    // when the buffer wrapped the first bytes may belong to a lost marker, whose time bytes can
+    // look like a marker too
+    while (i < count && !(is_marker(data, i, count) && stream_valid(data, i, count)))
+        i++;
+
+    if (i > 0)
+        printf("(%u bytes skipped until the first marker)\n", i);
+
+    uint8_t line[BYTES_PER_LINE];
+    int line_size = 0, first = 1, direction = 0;
+    uint32_t time = 0, last_raw = 0, epoch = 0;
+    int have_time = 0;
+
+    while (i < count)
+    {
+        uint8_t byte = data[i++];
+
+        if (byte == TRACE_ESCAPE && i < count)
+        {
+            uint8_t next = data[i++];
+
+            if (next & TRACE_MARKER)
+            {
+                if (i + 2 > count)
+                    break;
+
+                if (line_size)
+                    print_line(time, direction, line, line_size, first);
+
+                // the firmware keeps 16 bits of milliseconds, unwrap them
+                uint32_t raw = data[i] | (data[i + 1] << 8);
+                i += 2;
+
+                if (have_time && raw < last_raw)
+                    epoch += 0x10000;
+
+                last_raw = raw;
+                have_time = 1;
+                time = epoch + raw;
+                direction = next & 1;
+                line_size = 0;
+                first = 1;
+                continue;
+            }
+
+            // literal escape byte
+            byte = TRACE_ESCAPE;
+        }
+
+        line[line_size++] = byte;
+        if (line_size == BYTES_PER_LINE)
+        {
+            print_line(time, direction, line, line_size, first);
+            line_size = 0;
+            first = 0;
+        }
+    }
+
+    if (line_size)
+        print_line(time, direction, line, line_size, first);
+
+    free(file);
+    return 0;
+}